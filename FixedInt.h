@@ -0,0 +1,456 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: FixedInt.h
+
+/*
+  Unsigned integers of a fixed number of bits, for values with a
+  known maximum width such as 256 bit hashes or keys:
+
+      FixedInt<256> h = 0x811C9DC5;
+      h = h * FNV_PRIME ^ byte;
+
+  Arithmetic wraps around mod 2^Bits the same way the built in
+  unsigned types do. The limbs live in the object, every loop runs
+  a compile time number of times so the compiler can unroll it, and
+  there are no signs or lengths to check. Everything except the
+  conversions to and from LongInt and text is constexpr.
+
+  Converting a LongInt keeps its value mod 2^Bits, so a negative
+  number comes out in two's complement. Use LongInt when a value
+  might outgrow Bits.
+*/
+
+#ifndef FIXED_INT_H
+#define FIXED_INT_H
+
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include "LongInt.h"
+
+template<int Bits>
+class FixedInt
+{
+    static_assert(Bits > 0 && Bits % LIMB_BITS == 0,
+                  "FixedInt needs a whole number of limbs");
+
+public:
+    static const int LIMBS = Bits / LIMB_BITS;
+
+    constexpr FixedInt() :
+        x_()
+    {
+        return;
+    }
+
+    //From a built in integer, wrapped mod 2^Bits like any other
+    //unsigned conversion.
+    template<class T, class = typename std::enable_if<
+                          std::is_integral<T>::value>::type>
+    constexpr FixedInt(const T v) :
+        x_()
+    {
+        unsigned long long u = static_cast<unsigned long long>(v);
+        const limb_t fill = (v < 0 ? ~limb_t(0) : 0);
+        for (int i = 0; i < LIMBS; i++)
+        {
+            x_[i] = (i < 2 ? static_cast<limb_t>(u) : fill);
+            u >>= (i < 2 ? LIMB_BITS : 0);
+        }
+
+        return;
+    }
+
+    //Narrowing drops the high limbs and widening adds zeros.
+    template<int B>
+    constexpr explicit FixedInt(const FixedInt<B> & f) :
+        x_()
+    {
+        for (int i = 0; i < LIMBS && i < FixedInt<B>::LIMBS; i++)
+            x_[i] = f.limb(i);
+
+        return;
+    }
+
+    //l mod 2^Bits.
+    explicit FixedInt(const LongInt & l) :
+        x_()
+    {
+        for (int i = 0; i < LIMBS && i < l.limb_count(); i++)
+            x_[i] = l.limbs()[i];
+
+        if (l.sign() == -1)
+            *this = -*this;
+
+        return;
+    }
+
+    LongInt to_longint() const
+    {
+        LongInt ret;
+        ret.x_.assign(x_, x_ + LIMBS);
+        ret.trim();
+
+        return ret;
+    }
+
+    explicit operator LongInt() const { return to_longint(); }
+
+    //Limb i, least significant first.
+    constexpr limb_t limb(const int i) const { return x_[i]; }
+    constexpr limb_t & limb(const int i) { return x_[i]; }
+
+    constexpr bool operator==(const FixedInt & f) const
+    {
+        for (int i = 0; i < LIMBS; i++)
+        {
+            if (x_[i] != f.x_[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool operator!=(const FixedInt & f) const { return !(*this == f); }
+
+    constexpr bool operator<(const FixedInt & f) const
+    {
+        for (int i = LIMBS - 1; i >= 0; i--)
+        {
+            if (x_[i] != f.x_[i])
+                return x_[i] < f.x_[i];
+        }
+
+        return false;
+    }
+
+    constexpr bool operator> (const FixedInt & f) const { return f < *this; }
+    constexpr bool operator<=(const FixedInt & f) const { return !(f < *this); }
+    constexpr bool operator>=(const FixedInt & f) const { return !(*this < f); }
+
+    constexpr explicit operator bool() const { return *this != FixedInt(); }
+
+    constexpr FixedInt & operator+=(const FixedInt & f)
+    {
+        dlimb_t carry = 0;
+        for (int i = 0; i < LIMBS; i++)
+        {
+            carry += static_cast<dlimb_t>(x_[i]) + f.x_[i];
+            x_[i] = static_cast<limb_t>(carry);
+            carry >>= LIMB_BITS;
+        }
+
+        return *this;
+    }
+
+    constexpr FixedInt & operator-=(const FixedInt & f)
+    {
+        limb_t borrow = 0;
+        for (int i = 0; i < LIMBS; i++)
+        {
+            dlimb_t d = static_cast<dlimb_t>(x_[i]) - f.x_[i] - borrow;
+            x_[i] = static_cast<limb_t>(d);
+            borrow = static_cast<limb_t>(d >> (2 * LIMB_BITS - 1));
+        }
+
+        return *this;
+    }
+
+    //Only the low Bits of the product are formed.
+    constexpr FixedInt & operator*=(const FixedInt & f)
+    {
+        limb_t r[LIMBS] = {};
+        for (int j = 0; j < LIMBS; j++)
+        {
+            dlimb_t carry = 0;
+            for (int i = 0; i + j < LIMBS; i++)
+            {
+                carry += static_cast<dlimb_t>(x_[i]) * f.x_[j] + r[i + j];
+                r[i + j] = static_cast<limb_t>(carry);
+                carry >>= LIMB_BITS;
+            }
+        }
+
+        for (int i = 0; i < LIMBS; i++)
+            x_[i] = r[i];
+
+        return *this;
+    }
+
+    //Throws DivideByZeroError.
+    constexpr FixedInt & operator/=(const FixedInt & f)
+    {
+        FixedInt r;
+        divmod(*this, f, *this, r);
+
+        return *this;
+    }
+
+    constexpr FixedInt & operator%=(const FixedInt & f)
+    {
+        FixedInt q;
+        divmod(*this, f, q, *this);
+
+        return *this;
+    }
+
+    constexpr FixedInt & operator&=(const FixedInt & f)
+    {
+        for (int i = 0; i < LIMBS; i++)
+            x_[i] &= f.x_[i];
+
+        return *this;
+    }
+
+    constexpr FixedInt & operator|=(const FixedInt & f)
+    {
+        for (int i = 0; i < LIMBS; i++)
+            x_[i] |= f.x_[i];
+
+        return *this;
+    }
+
+    constexpr FixedInt & operator^=(const FixedInt & f)
+    {
+        for (int i = 0; i < LIMBS; i++)
+            x_[i] ^= f.x_[i];
+
+        return *this;
+    }
+
+    //Shifts by Bits or more give 0.
+    constexpr FixedInt & operator<<=(const int s)
+    {
+        const int w = s / LIMB_BITS, b = s % LIMB_BITS;
+        for (int i = LIMBS - 1; i >= 0; i--)
+        {
+            limb_t hi = (i - w >= 0 ? x_[i - w] : 0),
+                lo = (i - w - 1 >= 0 ? x_[i - w - 1] : 0);
+            x_[i] = (b == 0 ? hi : (hi << b) | (lo >> (LIMB_BITS - b)));
+        }
+
+        return *this;
+    }
+
+    constexpr FixedInt & operator>>=(const int s)
+    {
+        const int w = s / LIMB_BITS, b = s % LIMB_BITS;
+        for (int i = 0; i < LIMBS; i++)
+        {
+            limb_t lo = (i + w < LIMBS ? x_[i + w] : 0),
+                hi = (i + w + 1 < LIMBS ? x_[i + w + 1] : 0);
+            x_[i] = (b == 0 ? lo : (lo >> b) | (hi << (LIMB_BITS - b)));
+        }
+
+        return *this;
+    }
+
+    constexpr FixedInt operator+(const FixedInt & f) const { return FixedInt(*this) += f; }
+    constexpr FixedInt operator-(const FixedInt & f) const { return FixedInt(*this) -= f; }
+    constexpr FixedInt operator*(const FixedInt & f) const { return FixedInt(*this) *= f; }
+    constexpr FixedInt operator/(const FixedInt & f) const { return FixedInt(*this) /= f; }
+    constexpr FixedInt operator%(const FixedInt & f) const { return FixedInt(*this) %= f; }
+    constexpr FixedInt operator&(const FixedInt & f) const { return FixedInt(*this) &= f; }
+    constexpr FixedInt operator|(const FixedInt & f) const { return FixedInt(*this) |= f; }
+    constexpr FixedInt operator^(const FixedInt & f) const { return FixedInt(*this) ^= f; }
+    constexpr FixedInt operator<<(const int s) const { return FixedInt(*this) <<= s; }
+    constexpr FixedInt operator>>(const int s) const { return FixedInt(*this) >>= s; }
+
+    constexpr FixedInt operator~() const
+    {
+        FixedInt ret;
+        for (int i = 0; i < LIMBS; i++)
+            ret.x_[i] = ~x_[i];
+
+        return ret;
+    }
+
+    //2^Bits - x.
+    constexpr FixedInt operator-() const { return ~*this + 1; }
+
+    constexpr FixedInt & operator++() { return *this += 1; }
+    constexpr FixedInt & operator--() { return *this -= 1; }
+    constexpr FixedInt operator++(int) { FixedInt t(*this); ++*this; return t; }
+    constexpr FixedInt operator--(int) { FixedInt t(*this); --*this; return t; }
+
+    constexpr int bit_length() const
+    {
+        for (int i = LIMBS - 1; i >= 0; i--)
+        {
+            if (x_[i] != 0)
+                return i * LIMB_BITS + limb_bits(x_[i]);
+        }
+
+        return 0;
+    }
+
+    constexpr bool test_bit(const int i) const
+    {
+        return i >= 0 && i < Bits && ((x_[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1);
+    }
+
+    std::string to_string(const int base = 10) const
+    {
+        return to_longint().to_string(base);
+    }
+
+    /*
+      Knuth's Algorithm D, as for LongInt but on fixed arrays so it
+      works at compile time. Throws DivideByZeroError. q and r may
+      be a or b.
+    */
+    static constexpr void divmod(const FixedInt & a, const FixedInt & b,
+                                 FixedInt & q, FixedInt & r)
+    {
+        int n = LIMBS;
+        while (n > 0 && b.x_[n - 1] == 0)
+            n--;
+        if (n == 0)
+            throw DivideByZeroError();
+
+        int m = LIMBS;
+        while (m > 0 && a.x_[m - 1] == 0)
+            m--;
+
+        FixedInt quot;
+        if (m < n)
+        {
+            r = a;
+            q = quot;
+            return;
+        }
+
+        //Single limb divisor.
+        if (n == 1)
+        {
+            const limb_t d = b.x_[0];
+            dlimb_t rem = 0;
+            for (int i = m - 1; i >= 0; i--)
+            {
+                rem = (rem << LIMB_BITS) | a.x_[i];
+                quot.x_[i] = static_cast<limb_t>(rem / d);
+                rem %= d;
+            }
+
+            q = quot;
+            r = FixedInt(rem);
+            return;
+        }
+
+        //Normalize so the divisor's top bit is set. u gets an extra
+        //limb for what is shifted out of a.
+        const int s = LIMB_BITS - limb_bits(b.x_[n - 1]);
+        limb_t v[LIMBS] = {}, u[LIMBS + 1] = {};
+        for (int i = n - 1; i >= 0; i--)
+            v[i] = (b.x_[i] << s) |
+                (s != 0 && i > 0 ? b.x_[i - 1] >> (LIMB_BITS - s) : 0);
+        u[m] = (s != 0 ? a.x_[m - 1] >> (LIMB_BITS - s) : 0);
+        for (int i = m - 1; i >= 0; i--)
+            u[i] = (a.x_[i] << s) |
+                (s != 0 && i > 0 ? a.x_[i - 1] >> (LIMB_BITS - s) : 0);
+
+        const dlimb_t base = dlimb_t(1) << LIMB_BITS;
+        for (int j = m - n; j >= 0; j--)
+        {
+            //Estimate from the top two limbs, at most two too big.
+            dlimb_t top = (static_cast<dlimb_t>(u[j + n]) << LIMB_BITS) |
+                u[j + n - 1];
+            dlimb_t qhat = top / v[n - 1], rhat = top % v[n - 1];
+            while (qhat >= base ||
+                   qhat * v[n - 2] > ((rhat << LIMB_BITS) | u[j + n - 2]))
+            {
+                qhat--;
+                rhat += v[n - 1];
+                if (rhat >= base)
+                    break;
+            }
+
+            //u[j..j + n] -= qhat * v.
+            dlimb_t carry = 0;
+            limb_t borrow = 0;
+            for (int i = 0; i < n; i++)
+            {
+                carry += qhat * v[i];
+                dlimb_t d = static_cast<dlimb_t>(u[i + j]) -
+                    static_cast<limb_t>(carry) - borrow;
+                u[i + j] = static_cast<limb_t>(d);
+                borrow = static_cast<limb_t>(d >> (2 * LIMB_BITS - 1));
+                carry >>= LIMB_BITS;
+            }
+            dlimb_t d = static_cast<dlimb_t>(u[j + n]) - carry - borrow;
+            u[j + n] = static_cast<limb_t>(d);
+
+            //Went negative: one too many, add v back.
+            if (d >> (2 * LIMB_BITS - 1))
+            {
+                qhat--;
+                dlimb_t c = 0;
+                for (int i = 0; i < n; i++)
+                {
+                    c += static_cast<dlimb_t>(u[i + j]) + v[i];
+                    u[i + j] = static_cast<limb_t>(c);
+                    c >>= LIMB_BITS;
+                }
+                u[j + n] += static_cast<limb_t>(c);
+            }
+
+            quot.x_[j] = static_cast<limb_t>(qhat);
+        }
+
+        //The remainder is the bottom n limbs of u, shifted back.
+        FixedInt rem;
+        for (int i = 0; i < n; i++)
+            rem.x_[i] = (u[i] >> s) |
+                (s != 0 ? u[i + 1] << (LIMB_BITS - s) : 0);
+
+        q = quot;
+        r = rem;
+
+        return;
+    }
+
+private:
+    limb_t x_[LIMBS];
+
+    //Bits needed to write x.
+    static constexpr int limb_bits(limb_t x)
+    {
+        int bits = 0;
+        for (; x != 0; x >>= 1)
+            bits++;
+
+        return bits;
+    }
+};
+
+
+//The full 2 * Bits product of a and b.
+template<int Bits>
+constexpr FixedInt<2 * Bits> mul_wide(const FixedInt<Bits> & a,
+                                      const FixedInt<Bits> & b)
+{
+    FixedInt<2 * Bits> r;
+    for (int j = 0; j < FixedInt<Bits>::LIMBS; j++)
+    {
+        dlimb_t carry = 0;
+        for (int i = 0; i < FixedInt<Bits>::LIMBS; i++)
+        {
+            carry += static_cast<dlimb_t>(a.limb(i)) * b.limb(j) +
+                r.limb(i + j);
+            r.limb(i + j) = static_cast<limb_t>(carry);
+            carry >>= LIMB_BITS;
+        }
+        r.limb(j + FixedInt<Bits>::LIMBS) = static_cast<limb_t>(carry);
+    }
+
+    return r;
+}
+
+template<int Bits>
+std::ostream & operator<<(std::ostream & out, const FixedInt<Bits> & f)
+{
+    return out << f.to_string();
+}
+
+#endif
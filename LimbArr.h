@@ -0,0 +1,245 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbArr.h
+
+#ifndef LIMB_ARR_H
+#define LIMB_ARR_H
+
+#include <algorithm>
+#include <utility>
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+
+/*
+  The limb storage behind LongInt. Works like a stripped down
+  std::vector<limb_t>, except that up to INLINE limbs (128 bits) live
+  inside the object itself and only longer values go to the heap.
+  Most LongInts are small, so most never allocate, and the blocks
+  of the rest are recycled through the thread's LimbPool.
+
+  New limbs from resize() are zero.
+*/
+class LimbArr
+{
+public:
+    static const int INLINE = 4;
+
+    LimbArr() :
+        size_(0),
+        capacity_(INLINE)
+    {
+        return;
+    }
+
+    //Constructor with a set starting size, all zeros.
+    explicit LimbArr(const int size) :
+        size_(0),
+        capacity_(INLINE)
+    {
+        resize(size);
+        return;
+    }
+
+    //Constructor copying the limbs in [first, last).
+    LimbArr(const limb_t * first, const limb_t * last) :
+        size_(0),
+        capacity_(INLINE)
+    {
+        assign(first, last);
+        return;
+    }
+
+    //Copy constructor.
+    LimbArr(const LimbArr & arr) :
+        size_(0),
+        capacity_(INLINE)
+    {
+        assign(arr.data(), arr.data() + arr.size());
+        return;
+    }
+
+    //Move constructor. Takes the heap block if there is one.
+    LimbArr(LimbArr && arr) noexcept :
+        size_(0),
+        capacity_(INLINE)
+    {
+        steal(arr);
+        return;
+    }
+
+    //Deconstructor.
+    ~LimbArr()
+    {
+        if (!is_inline())
+            limbs_free(heap_, capacity_);
+        return;
+    }
+
+    LimbArr & operator=(const LimbArr & arr)
+    {
+        if (this != &arr)
+            assign(arr.data(), arr.data() + arr.size());
+
+        return *this;
+    }
+
+    LimbArr & operator=(LimbArr && arr) noexcept
+    {
+        if (this != &arr)
+        {
+            release();
+            steal(arr);
+        }
+
+        return *this;
+    }
+
+    inline
+    int size() const { return size_; }
+    inline
+    int capacity() const { return capacity_; }
+    inline
+    bool empty() const { return size_ == 0; }
+
+    //True while the limbs are stored in the object itself.
+    inline
+    bool is_inline() const { return capacity_ == INLINE; }
+
+    inline
+    limb_t * data() { return is_inline() ? inline_ : heap_; }
+    inline
+    const limb_t * data() const { return is_inline() ? inline_ : heap_; }
+
+    inline
+    limb_t & operator[](const int i) { return data()[i]; }
+    inline
+    limb_t operator[](const int i) const { return data()[i]; }
+
+    inline
+    limb_t & back() { return data()[size_ - 1]; }
+    inline
+    limb_t back() const { return data()[size_ - 1]; }
+
+    //Make room for at least capacity limbs, keeping the current
+    //ones.
+    void reserve(const int capacity)
+    {
+        if (capacity <= capacity_)
+            return;
+
+        int new_capacity = std::max(capacity, capacity_ * 2);
+        limb_t * new_x = limbs_alloc(new_capacity);
+        std::copy(data(), data() + size_, new_x);
+
+        if (!is_inline())
+            limbs_free(heap_, capacity_);
+        heap_ = new_x;
+        capacity_ = new_capacity;
+
+        return;
+    }
+
+    void resize(const int size)
+    {
+        reserve(size);
+        if (size > size_)
+            std::fill(data() + size_, data() + size, 0);
+        size_ = size;
+
+        return;
+    }
+
+    inline
+    void push_back(const limb_t x)
+    {
+        if (size_ == capacity_)
+            reserve(size_ + 1);
+        data()[size_++] = x;
+
+        return;
+    }
+
+    inline
+    void pop_back() { size_--; }
+
+    //Empties the array but keeps its storage.
+    inline
+    void clear() { size_ = 0; }
+
+    void assign(const limb_t * first, const limb_t * last)
+    {
+        int size = last - first;
+        if (size > capacity_)
+        {
+            release();
+            reserve(size);
+        }
+
+        std::copy(first, last, data());
+        size_ = size;
+
+        return;
+    }
+
+    void swap(LimbArr & arr)
+    {
+        LimbArr t(std::move(arr));
+        arr = std::move(*this);
+        *this = std::move(t);
+
+        return;
+    }
+
+    bool operator==(const LimbArr & arr) const
+    {
+        return size_ == arr.size() &&
+            std::equal(data(), data() + size_, arr.data());
+    }
+
+    bool operator!=(const LimbArr & arr) const
+    {
+        return !(*this == arr);
+    }
+
+private:
+    int size_;
+    int capacity_;
+    union
+    {
+        limb_t inline_[INLINE];
+        limb_t * heap_;
+    };
+
+    //Go back to empty inline storage.
+    void release()
+    {
+        if (!is_inline())
+            limbs_free(heap_, capacity_);
+        size_ = 0;
+        capacity_ = INLINE;
+
+        return;
+    }
+
+    //Take arr's contents, leaving it empty. This must be empty
+    //and inline.
+    void steal(LimbArr & arr)
+    {
+        if (arr.is_inline())
+            std::copy(arr.inline_, arr.inline_ + arr.size_, inline_);
+        else
+        {
+            heap_ = arr.heap_;
+            capacity_ = arr.capacity_;
+            arr.capacity_ = INLINE;
+        }
+
+        size_ = arr.size_;
+        arr.size_ = 0;
+
+        return;
+    }
+};
+
+#endif
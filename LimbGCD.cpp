@@ -0,0 +1,745 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbGCD.cpp
+
+/*
+  Greatest common divisors of limb arrays.
+
+  Everything here is Euclid's algorithm done in big steps. A step is
+  a 2x2 matrix M with non negative entries and determinant +-1, and
+  (a, b) = M (alpha, beta) for the new pair. Such a matrix never
+  changes the gcd, and the cofactors of the new pair follow from M,
+  so it does not matter how M was found as long as alpha and beta
+  come out positive and smaller.
+
+  Lehmer: run Euclid on the top 62 bits of a and b natively and
+  stop while the cofactors are still small enough that the steps
+  are certainly valid for the full numbers. One pass over the limbs
+  then does about 30 bits of reduction instead of one quotient.
+
+  Half-GCD: for large inputs, find the matrix that reduces a and b
+  to about half their length by recursing on the top half twice,
+  then apply it with fast multiplication. This is Schonhage's
+  algorithm as described by Moller, "On Schonhage's algorithm and
+  subquadratic integer gcd computation", with a simpler stopping
+  rule: hgcd(a, b, h) only takes steps that leave both numbers at
+  least 2^h.
+*/
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+#include "LongIntStats.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    typedef LimbVector Limbs;
+
+    const dlimb_t LIMB_MAX = 0xFFFFFFFF;
+
+    //How many top bits the Lehmer step looks at. Leaves room for
+    //the quotient arithmetic in a dlimb_t.
+    const int LEHMER_BITS = 62;
+
+
+    inline
+    void trim(Limbs & x)
+    {
+        x.resize(limbs_normalize(x.data(), x.size()));
+        return;
+    }
+
+    inline
+    int cmp(const Limbs & x, const Limbs & y)
+    {
+        return limbs_cmp(x.data(), x.size(), y.data(), y.size());
+    }
+
+    int bit_length(const Limbs & x)
+    {
+        if (x.empty())
+            return 0;
+
+        int bits = (x.size() - 1) * LIMB_BITS;
+        for (limb_t top = x.back(); top != 0; top >>= 1)
+            bits++;
+
+        return bits;
+    }
+
+    inline
+    limb_t limb_at(const Limbs & x, const int i)
+    {
+        return (i < static_cast<int>(x.size()) ? x[i] : 0);
+    }
+
+    //x >> s, for an x below 2^(s + 64).
+    dlimb_t top_bits(const Limbs & x, const int s)
+    {
+        const int w = s / LIMB_BITS, b = s % LIMB_BITS;
+        dlimb_t lo = limb_at(x, w) |
+            static_cast<dlimb_t>(limb_at(x, w + 1)) << LIMB_BITS;
+        dlimb_t hi = limb_at(x, w + 2);
+
+        return (b == 0 ? lo : (lo >> b) | (hi << (2 * LIMB_BITS - b)));
+    }
+
+    //x >> p.
+    Limbs shift_down(const Limbs & x, const int p)
+    {
+        const int w = p / LIMB_BITS;
+        const unsigned s = p % LIMB_BITS;
+        if (w >= static_cast<int>(x.size()))
+            return Limbs();
+
+        Limbs r(x.begin() + w, x.end());
+        if (s != 0)
+            limbs_rshift(r.data(), r.data(), r.size(), s);
+        trim(r);
+
+        return r;
+    }
+
+    //x mod 2^p.
+    Limbs low_bits(const Limbs & x, const int p)
+    {
+        const int w = p / LIMB_BITS;
+        if (w >= static_cast<int>(x.size()))
+            return x;
+
+        Limbs r(x.begin(), x.begin() + w + 1);
+        r[w] &= (limb_t(1) << (p % LIMB_BITS)) - 1;
+        trim(r);
+
+        return r;
+    }
+
+    Limbs mul(const Limbs & x, const Limbs & y)
+    {
+        if (x.empty() || y.empty())
+            return Limbs();
+
+        const Limbs & big = (x.size() >= y.size() ? x : y);
+        const Limbs & small = (x.size() >= y.size() ? y : x);
+
+        Limbs r(big.size() + small.size());
+        limbs_mul(r.data(), big.data(), big.size(),
+                  small.data(), small.size());
+        trim(r);
+
+        return r;
+    }
+
+    Limbs add(const Limbs & x, const Limbs & y)
+    {
+        const Limbs & big = (x.size() >= y.size() ? x : y);
+        const Limbs & small = (x.size() >= y.size() ? y : x);
+
+        Limbs r(big);
+        r.push_back(0);
+        r.back() = limbs_add(r.data(), r.data(), big.size(),
+                             small.data(), small.size());
+        trim(r);
+
+        return r;
+    }
+
+    //|x - y|.
+    Limbs abs_diff(const Limbs & x, const Limbs & y)
+    {
+        if (cmp(x, y) < 0)
+            return abs_diff(y, x);
+
+        Limbs r(x);
+        limbs_sub(r.data(), r.data(), x.size(), y.data(), y.size());
+        trim(r);
+
+        return r;
+    }
+
+    //hi * 2^p + sign * (x - y), known to be non negative.
+    Limbs join(const Limbs & hi, const int p, const Limbs & x,
+               const Limbs & y, const int sign)
+    {
+        const int w = p / LIMB_BITS;
+        const unsigned s = p % LIMB_BITS;
+        const int c = cmp(x, y);
+        const Limbs d = abs_diff(x, y);
+
+        Limbs r(std::max<int>(w + hi.size(), d.size()) + 2);
+        if (!hi.empty())
+        {
+            std::copy(hi.begin(), hi.end(), r.begin() + w);
+            if (s != 0)
+                r[w + hi.size()] = limbs_lshift(r.data() + w, r.data() + w,
+                                                hi.size(), s);
+        }
+
+        if (!d.empty())
+        {
+            if (c * sign > 0)
+                limbs_add(r.data(), r.data(), r.size(), d.data(), d.size());
+            else
+                limbs_sub(r.data(), r.data(), r.size(), d.data(), d.size());
+        }
+        trim(r);
+
+        return r;
+    }
+
+    //(x, y) = (p x + q y, r x + s y) for single limb p, q, r, s,
+    //in one pass over both.
+    void lin_add(Limbs & x, Limbs & y, const limb_t p, const limb_t q,
+                 const limb_t r, const limb_t s)
+    {
+        const int n = std::max(x.size(), y.size()) + 1;
+        x.resize(n + 1);
+        y.resize(n + 1);
+
+        //p x_i + carry fits a dlimb_t, adding q y_i can carry out
+        //of it, so the two halves are added separately.
+        dlimb_t cx = 0, cy = 0;
+        for (int i = 0; i <= n; i++)
+        {
+            const limb_t xi = x[i], yi = y[i];
+            dlimb_t px = static_cast<dlimb_t>(p) * xi + cx,
+                qy = static_cast<dlimb_t>(q) * yi;
+            dlimb_t rx = static_cast<dlimb_t>(r) * xi + cy,
+                sy = static_cast<dlimb_t>(s) * yi;
+
+            x[i] = static_cast<limb_t>(px + qy);
+            y[i] = static_cast<limb_t>(rx + sy);
+            cx = (px >> LIMB_BITS) + (qy >> LIMB_BITS) +
+                (((px & LIMB_MAX) + (qy & LIMB_MAX)) >> LIMB_BITS);
+            cy = (rx >> LIMB_BITS) + (sy >> LIMB_BITS) +
+                (((rx & LIMB_MAX) + (sy & LIMB_MAX)) >> LIMB_BITS);
+        }
+
+        trim(x);
+        trim(y);
+
+        return;
+    }
+
+    //(x, y) = (p x - q y, s y - r x) for single limb p, q, r, s
+    //when both results are known to be non negative and no longer
+    //than x or y, in one pass over both.
+    void lin_sub(Limbs & x, Limbs & y, const limb_t p, const limb_t q,
+                 const limb_t r, const limb_t s)
+    {
+        const int n = std::max(x.size(), y.size());
+        x.resize(n);
+        y.resize(n);
+
+        dlimb_t cpx = 0, cqy = 0, crx = 0, csy = 0;
+        limb_t bx = 0, by = 0;
+        for (int i = 0; i < n; i++)
+        {
+            const limb_t xi = x[i], yi = y[i];
+            cpx += static_cast<dlimb_t>(p) * xi;
+            cqy += static_cast<dlimb_t>(q) * yi;
+            crx += static_cast<dlimb_t>(r) * xi;
+            csy += static_cast<dlimb_t>(s) * yi;
+
+            dlimb_t dx = (cpx & LIMB_MAX) - (cqy & LIMB_MAX) - bx;
+            dlimb_t dy = (csy & LIMB_MAX) - (crx & LIMB_MAX) - by;
+            x[i] = static_cast<limb_t>(dx);
+            y[i] = static_cast<limb_t>(dy);
+            bx = static_cast<limb_t>(dx >> (2 * LIMB_BITS - 1));
+            by = static_cast<limb_t>(dy >> (2 * LIMB_BITS - 1));
+
+            cpx >>= LIMB_BITS;
+            cqy >>= LIMB_BITS;
+            crx >>= LIMB_BITS;
+            csy >>= LIMB_BITS;
+        }
+
+        trim(x);
+        trim(y);
+
+        return;
+    }
+
+
+    //A step of Euclid's algorithm, (a, b) = M (alpha, beta).
+    struct Matrix
+    {
+        Limbs m[2][2];
+        int det;
+
+        Matrix() :
+            det(1)
+        {
+            m[0][0].push_back(1);
+            m[1][1].push_back(1);
+            return;
+        }
+
+        bool is_identity() const
+        {
+            return det == 1 && m[0][1].empty() && m[1][0].empty() &&
+                m[0][0].size() == 1 && m[0][0][0] == 1 &&
+                m[1][1].size() == 1 && m[1][1][0] == 1;
+        }
+    };
+
+    //A step small enough for single limb entries.
+    struct Matrix1
+    {
+        limb_t m[2][2];
+        int det;
+    };
+
+
+    //M = M * [[0, 1], [1, 0]].
+    void swap_columns(Matrix & M)
+    {
+        M.m[0][0].swap(M.m[0][1]);
+        M.m[1][0].swap(M.m[1][1]);
+        M.det = -M.det;
+
+        return;
+    }
+
+    //M = M * K.
+    void mul_right(Matrix & M, const Matrix1 & K)
+    {
+        for (int i = 0; i < 2; i++)
+            lin_add(M.m[i][0], M.m[i][1], K.m[0][0], K.m[1][0],
+                    K.m[0][1], K.m[1][1]);
+        M.det *= K.det;
+
+        return;
+    }
+
+    //M = M * [[q, 1], [1, 0]].
+    void mul_right_q(Matrix & M, const Limbs & q)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            Limbs c0 = add(mul(M.m[i][0], q), M.m[i][1]);
+            M.m[i][1].swap(M.m[i][0]);
+            M.m[i][0].swap(c0);
+        }
+        M.det = -M.det;
+
+        return;
+    }
+
+    //M = M * N.
+    void mul_right(Matrix & M, const Matrix & N)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            Limbs c0 = add(mul(M.m[i][0], N.m[0][0]), mul(M.m[i][1], N.m[1][0]));
+            Limbs c1 = add(mul(M.m[i][0], N.m[0][1]), mul(M.m[i][1], N.m[1][1]));
+            M.m[i][0].swap(c0);
+            M.m[i][1].swap(c1);
+        }
+        M.det *= N.det;
+
+        return;
+    }
+
+
+    //(a, b) = K^-1 (a, b). K^-1 is +-[[k11, -k01], [-k10, k00]],
+    //and the results are known to be positive.
+    void apply_inverse(Limbs & a, Limbs & b, const Matrix1 & K)
+    {
+        //The signs of the two differences follow the determinant.
+        if (K.det == 1)
+            lin_sub(a, b, K.m[1][1], K.m[0][1], K.m[1][0], K.m[0][0]);
+        else
+        {
+            lin_sub(b, a, K.m[0][1], K.m[1][1], K.m[0][0], K.m[1][0]);
+            a.swap(b);
+        }
+
+        return;
+    }
+
+
+    /*
+      Cofactors of the first input for the current pair:
+          a = s0 * a0 + ... and b = s1 * a0 + ...
+      Euclid's cofactors alternate in sign, so only magnitudes and
+      the sign of s0 are kept; s1 has the other sign.
+    */
+    struct Cofactors
+    {
+        Limbs s0, s1;
+        int sign;
+    };
+
+    //Move the cofactors along a step M. For (a, b) = M (alpha,
+    //beta), alpha = det * (m11 * a - m01 * b) and s0, s1 have
+    //opposite signs, so the magnitudes add.
+    void update(Cofactors & c, const Matrix & M)
+    {
+        Limbs s0 = add(mul(M.m[1][1], c.s0), mul(M.m[0][1], c.s1));
+        Limbs s1 = add(mul(M.m[1][0], c.s0), mul(M.m[0][0], c.s1));
+        c.s0.swap(s0);
+        c.s1.swap(s1);
+        c.sign *= M.det;
+
+        return;
+    }
+
+    void update(Cofactors & c, const Matrix1 & K)
+    {
+        lin_add(c.s0, c.s1, K.m[1][1], K.m[0][1], K.m[1][0], K.m[0][0]);
+        c.sign *= K.det;
+
+        return;
+    }
+
+    //Step [[q, 1], [1, 0]]: s0, s1 = s1, s0 + q * s1.
+    void update_q(Cofactors & c, const Limbs & q)
+    {
+        Limbs s1 = add(c.s0, mul(q, c.s1));
+        c.s0.swap(c.s1);
+        c.s1.swap(s1);
+        c.sign = -c.sign;
+
+        return;
+    }
+
+    void swap_pair(Limbs & a, Limbs & b, Cofactors * c)
+    {
+        a.swap(b);
+        if (c != nullptr)
+        {
+            c->s0.swap(c->s1);
+            c->sign = -c->sign;
+        }
+
+        return;
+    }
+
+
+    /*
+      Lehmer step for a >= b > 0: Euclid on the top bits of both,
+      keeping only steps after which both full numbers are still at
+      least 2^h. Returns false if it could not take any.
+
+      With a = 2^s a' + a'' and b = 2^s b' + b'', a remainder r' of
+      the top bits with cofactors u, v stands for the true remainder
+      2^s r' + (u a'' + v b''), which is off by less than
+      2^s max(|u|, |v|). So r' - max(|u|, |v|) >= 2^(h - s) is
+      enough.
+    */
+    bool lehmer_matrix(const Limbs & a, const Limbs & b, const int h,
+                       Matrix1 & K)
+    {
+        const int s = std::max(bit_length(a) - LEHMER_BITS, 0);
+        if (h - s >= LEHMER_BITS)
+            return false;
+
+        const dlimb_t bound = (h > s ? dlimb_t(1) << (h - s) : 1);
+        dlimb_t x = top_bits(a, s), y = top_bits(b, s);
+        dlimb_t k00 = 1, k01 = 0, k10 = 0, k11 = 1;
+        int det = 1;
+
+        while (y != 0)
+        {
+            dlimb_t q = x / y, r = x - q * y;
+            if (q > LIMB_MAX)
+                break;
+
+            dlimb_t n00 = k00 * q + k01, n10 = k10 * q + k11;
+            if (n00 > LIMB_MAX || n10 > LIMB_MAX)
+                break;
+
+            //Exact when nothing was cut off.
+            dlimb_t err = (s == 0 ? 0 : std::max(n00, n10));
+            if (r < bound + err)
+                break;
+
+            k01 = k00;
+            k00 = n00;
+            k11 = k10;
+            k10 = n10;
+            det = -det;
+            x = y;
+            y = r;
+        }
+
+        K.m[0][0] = static_cast<limb_t>(k00);
+        K.m[0][1] = static_cast<limb_t>(k01);
+        K.m[1][0] = static_cast<limb_t>(k10);
+        K.m[1][1] = static_cast<limb_t>(k11);
+        K.det = det;
+
+        return k01 != 0 || k10 != 0;
+    }
+
+
+    //q = a / b and a = a % b.
+    void divide(Limbs & q, Limbs & a, const Limbs & b)
+    {
+        if (cmp(a, b) < 0)
+        {
+            q.clear();
+            return;
+        }
+
+        Limbs r(b.size());
+        q.resize(a.size() - b.size() + 1);
+        limbs_divrem(q.data(), r.data(), a.data(), a.size(),
+                     b.data(), b.size());
+        trim(q);
+        trim(r);
+        a.swap(r);
+
+        return;
+    }
+
+
+    //Reduce a, b >= 2^h by Lehmer steps while both stay at least
+    //2^h, accumulating the steps in M.
+    void hgcd_base(Limbs & a, Limbs & b, const int h, Matrix & M)
+    {
+        Matrix1 K;
+        Limbs q;
+
+        for (;;)
+        {
+            if (cmp(a, b) < 0)
+            {
+                a.swap(b);
+                swap_columns(M);
+            }
+
+            if (bit_length(b) <= h)
+                break;
+
+            if (lehmer_matrix(a, b, h, K))
+            {
+                apply_inverse(a, b, K);
+                mul_right(M, K);
+                continue;
+            }
+
+            //A quotient too big for the Lehmer step, take it
+            //exactly.
+            Limbs r(a);
+            divide(q, r, b);
+            if (bit_length(r) <= h)
+                break;
+
+            a.swap(b);
+            b.swap(r);
+            mul_right_q(M, q);
+        }
+
+        return;
+    }
+
+
+    //Shared by both halves of hgcd: reduce the top bits of a and
+    //b above bit p with threshold hp, then carry the step over to
+    //all of a and b.
+    void hgcd_top(Limbs & a, Limbs & b, const int p, const int hp,
+                  Matrix & M);
+
+    /*
+      Reduce a, b >= 2^h so they are still at least 2^h, with
+      h > bits / 2. The matrix bound that makes this work: since
+      a >= m00 * alpha and so on, every entry of M is less than
+      2^bits / 2^h, which is below 2^h.
+
+      For the top T bits above bit p, reduced with threshold
+      T / 2 + 1, the error from the low bits is less than
+      2^p * |M| < 2^p * 2^(hp - 1), so the full numbers stay above
+      2^(p + hp - 1). The first half cuts at p = h; the second cuts
+      as low as that allows, which brings a and b down close to 2^h.
+    */
+    void hgcd(Limbs & a, Limbs & b, const int h, Matrix & M)
+    {
+        if (bit_length(a) <= h || bit_length(b) <= h)
+            return;
+
+        const int dc_bits = limb_thresholds.hgcd * LIMB_BITS;
+        const int bits = std::max(bit_length(a), bit_length(b));
+
+        //The top parts recursed on are about 2 * (bits - h) long.
+        if (2 * (bits - h) >= dc_bits)
+            hgcd_top(a, b, h, (bits - h) / 2 + 1, M);
+
+        //The second half only pays off if the first got somewhere.
+        //It stalls when a and b are nearly at their gcd, and
+        //recursing anyway would blow up.
+        const int bits2 = std::max(bit_length(a), bit_length(b));
+        if (2 * (bits2 - h) >= dc_bits && 4 * (bits2 - h) <= 3 * (bits - h))
+        {
+            int p = std::max(2 * h - bits2, 0);
+            while (p + (bits2 - p) / 2 < h)
+                p++;
+            hgcd_top(a, b, p, (bits2 - p) / 2 + 1, M);
+        }
+
+        hgcd_base(a, b, h, M);
+
+        return;
+    }
+
+    void hgcd_top(Limbs & a, Limbs & b, const int p, const int hp,
+                  Matrix & M)
+    {
+        Limbs a_hi = shift_down(a, p), b_hi = shift_down(b, p);
+        Matrix M1;
+        hgcd(a_hi, b_hi, hp, M1);
+
+        if (!M1.is_identity())
+        {
+            //The top bits are already reduced, so only the low p
+            //bits still need multiplying by M1^-1.
+            Limbs a_lo = low_bits(a, p), b_lo = low_bits(b, p);
+            a = join(a_hi, p, mul(M1.m[1][1], a_lo), mul(M1.m[0][1], b_lo),
+                     M1.det);
+            b = join(b_hi, p, mul(M1.m[0][0], b_lo), mul(M1.m[1][0], a_lo),
+                     M1.det);
+            mul_right(M, M1);
+        }
+
+        return;
+    }
+
+
+    //Euclid to the end on a, b, tracking cofactors if c is
+    //given. Leaves the gcd in a and zero in b.
+    void gcd_loop(Limbs & a, Limbs & b, Cofactors * c)
+    {
+        Matrix1 K;
+        Limbs q;
+
+        while (!b.empty())
+        {
+            if (cmp(a, b) < 0)
+                swap_pair(a, b, c);
+
+            //Large and close in size: half-GCD.
+            if (static_cast<int>(b.size()) >= limb_thresholds.gcd_dc)
+            {
+                const int h = bit_length(a) / 2 + 1;
+                if (bit_length(b) > h)
+                {
+                    Matrix M;
+                    {
+                        StatTimer timer(TIER_GCD_HGCD);
+                        hgcd(a, b, h, M);
+                    }
+                    if (!M.is_identity())
+                    {
+                        if (c != nullptr)
+                            update(*c, M);
+                        continue;
+                    }
+                }
+            }
+
+            if (lehmer_matrix(a, b, 0, K))
+            {
+                apply_inverse(a, b, K);
+                if (c != nullptr)
+                    update(*c, K);
+                continue;
+            }
+
+            divide(q, a, b);
+            a.swap(b);
+            if (c != nullptr)
+                update_q(*c, q);
+        }
+
+        return;
+    }
+
+
+    //Binary gcd of two non zero native values.
+    dlimb_t gcd_binary(dlimb_t x, dlimb_t y)
+    {
+        int shift = 0;
+        while (((x | y) & 1) == 0)
+        {
+            x >>= 1;
+            y >>= 1;
+            shift++;
+        }
+        while ((x & 1) == 0)
+            x >>= 1;
+
+        while (y != 0)
+        {
+            while ((y & 1) == 0)
+                y >>= 1;
+            if (x > y)
+                std::swap(x, y);
+            y -= x;
+        }
+
+        return x << shift;
+    }
+}
+
+
+int limbs_gcd(limb_t * g, const limb_t * a, const int an,
+              const limb_t * b, const int bn)
+{
+    if (an <= 2 && bn <= 2)
+    {
+        dlimb_t x = a[0] | (an == 2 ? static_cast<dlimb_t>(a[1]) << LIMB_BITS : 0);
+        dlimb_t y = b[0] | (bn == 2 ? static_cast<dlimb_t>(b[1]) << LIMB_BITS : 0);
+        dlimb_t d = gcd_binary(x, y);
+
+        g[0] = static_cast<limb_t>(d);
+        if ((d >> LIMB_BITS) == 0)
+            return 1;
+
+        g[1] = static_cast<limb_t>(d >> LIMB_BITS);
+        return 2;
+    }
+
+    StatTimer timer(TIER_GCD_LEHMER);
+    Limbs x(a, a + an), y(b, b + bn);
+    gcd_loop(x, y, nullptr);
+    std::copy(x.begin(), x.end(), g);
+
+    return x.size();
+}
+
+
+int limbs_gcdext(limb_t * g, limb_t * s, int * sn, const limb_t * a,
+                 const int an, const limb_t * b, const int bn)
+{
+    StatTimer timer(TIER_GCD_LEHMER);
+    Limbs x(a, a + an), y(b, b + bn);
+    Cofactors c;
+    c.s0.push_back(1);
+    c.sign = 1;
+
+    gcd_loop(x, y, &c);
+    std::copy(x.begin(), x.end(), g);
+
+    //Any s + k * (b / g) works too. Pick the one nearest zero,
+    //so |s| <= b / (2g).
+    Limbs bg(bn - x.size() + 1), r(x.size());
+    limbs_divrem(bg.data(), r.data(), b, bn, x.data(), x.size());
+    trim(bg);
+
+    if (cmp(c.s0, bg) >= 0)
+        divide(r, c.s0, bg);
+    Limbs twice = add(c.s0, c.s0);
+    if (cmp(twice, bg) > 0)
+    {
+        c.s0 = abs_diff(bg, c.s0);
+        c.sign = -c.sign;
+    }
+
+    std::copy(c.s0.begin(), c.s0.end(), s);
+    *sn = (c.sign < 0 ? -1 : 1) * static_cast<int>(c.s0.size());
+
+    return x.size();
+}
@@ -0,0 +1,106 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbMod.cpp
+
+/*
+  Reduction modulo a fixed n limb m, for repeated modular
+  multiplication.
+
+  Montgomery reduction needs m odd and works with numbers scaled by
+  R = 2^(32n): it divides by R instead of by m, and dividing by R is
+  just dropping limbs. It costs one limb row per limb of m.
+
+  Barrett reduction works for any m. It replaces the division by m
+  with two multiplications by the precomputed 2^(64n) / m, so it
+  gets faster along with limbs_mul.
+*/
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+
+#include <algorithm>
+
+
+limb_t limbs_mont_inv(const limb_t m0)
+{
+    //Newton's iteration for 1 / m0 mod 2^32. m0 is its own
+    //inverse mod 8, and each step doubles the correct bits.
+    limb_t inv = m0;
+    for (int i = 0; i < 4; i++)
+        inv *= 2 - m0 * inv;
+
+    return -inv;
+}
+
+
+void limbs_redc(limb_t * r, limb_t * t, const limb_t * m, const int n,
+                const limb_t inv)
+{
+    //Each row clears the bottom limb of t. Its carry belongs n
+    //limbs up, but no later row looks that high, so the carry is
+    //parked in the limb the row just cleared and all of them are
+    //added back in one pass.
+    for (int i = 0; i < n; i++)
+    {
+        limb_t q = t[i] * inv;
+        t[i] = limbs_addmul_1(t + i, m, n, q);
+    }
+
+    limb_t carry = limbs_add_n(r, t + n, t, n);
+
+    //The sum is less than 2m.
+    if (carry != 0 || limbs_cmp(r, limbs_normalize(r, n), m, n) >= 0)
+        limbs_sub_n(r, r, m, n);
+
+    return;
+}
+
+
+void limbs_barrett_inv(limb_t * mu, const limb_t * m, const int n)
+{
+    std::fill(mu, mu + n + 2, 0);
+
+    LimbVector num(2 * n + 1), rem(n);
+    num[2 * n] = 1;
+
+    limbs_divrem(mu, rem.data(), num.data(), 2 * n + 1, m, n);
+
+    return;
+}
+
+
+int limbs_barrett_scratch(const int n)
+{
+    return 5 * n + 5;
+}
+
+
+void limbs_barrett_reduce(limb_t * r, const limb_t * t,
+                          const limb_t * m, const int n,
+                          const limb_t * mu, limb_t * scratch)
+{
+    //Handbook of Applied Cryptography, algorithm 14.42. The
+    //estimate q3 = (t / B^(n-1)) * mu / B^(n+1) is at most two
+    //short of t / m, so t - q3 * m is less than 3m. Only its low
+    //n + 1 limbs are needed.
+    const int mun = std::max(limbs_normalize(mu, n + 2), 1);
+    limb_t * q2 = scratch;                 //2n + 3 limbs
+    limb_t * p = q2 + (n + 1) + mun;       //2n + 1 limbs
+    limb_t * x = p + 2 * n + 1;            //n + 1 limbs
+
+    if (mun > n + 1)
+        limbs_mul(q2, mu, mun, t + n - 1, n + 1);
+    else
+        limbs_mul(q2, t + n - 1, n + 1, mu, mun);
+
+    const limb_t * q3 = q2 + n + 1;
+    limbs_mul(p, q3, n + 1, m, n);
+    limbs_sub_n(x, t, p, n + 1);
+
+    while (limbs_cmp(x, limbs_normalize(x, n + 1), m, n) >= 0)
+        limbs_sub(x, x, n + 1, m, n);
+
+    std::copy(x, x + n, r);
+
+    return;
+}
@@ -0,0 +1,240 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbNTT.cpp
+
+/*
+  Multiplication by number theoretic transform. Each operand's
+  limbs are the coefficients of a polynomial, the polynomials are
+  multiplied by cyclic convolution modulo three NTT friendly primes
+  and the exact coefficients are put back together with the Chinese
+  remainder theorem. Everything is integer arithmetic, so there is
+  no rounding to worry about.
+
+  A coefficient of the product is at most
+      min(an, bn) * (2^32 - 1)^2 < 2^23 * 2^64 = 2^87
+  for the lengths we allow, and the product of the three primes is
+  about 2^89, so the CRT result is always the exact coefficient.
+*/
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+#include "LimbThreads.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    template<limb_t P, limb_t G>
+    struct NttPrime
+    {
+        static const limb_t MOD = P;
+
+        static limb_t mul(const limb_t a, const limb_t b)
+        {
+            //P is a constant, so the compiler turns this into
+            //multiplies and shifts.
+            return static_cast<limb_t>(static_cast<dlimb_t>(a) * b % P);
+        }
+
+        static limb_t add(const limb_t a, const limb_t b)
+        {
+            limb_t s = a + b;
+            return (s >= P ? s - P : s);
+        }
+
+        static limb_t sub(const limb_t a, const limb_t b)
+        {
+            return (a >= b ? a - b : a + P - b);
+        }
+
+        static limb_t pow(limb_t a, dlimb_t e)
+        {
+            limb_t ret = 1;
+            while (e != 0)
+            {
+                if (e & 1)
+                    ret = mul(ret, a);
+                a = mul(a, a);
+                e >>= 1;
+            }
+
+            return ret;
+        }
+
+        //Butterflies lo up to hi of the stage with the given half
+        //length, counted block by block.
+        static void butterflies(limb_t * a, const limb_t * w,
+                                const int half, int lo, const int hi)
+        {
+            while (lo < hi)
+            {
+                const int i = lo / half * 2 * half, j0 = lo % half;
+                const int end = std::min(half, j0 + hi - lo);
+                for (int j = j0; j < end; j++)
+                {
+                    limb_t u = a[i + j],
+                        v = mul(a[i + j + half], w[j]);
+                    a[i + j] = add(u, v);
+                    a[i + j + half] = sub(u, v);
+                }
+                lo += end - j0;
+            }
+
+            return;
+        }
+
+        //In place transform of n (a power of two) values.
+        static void transform(limb_t * a, const int n, const bool inverse)
+        {
+            //Bit reversed order.
+            for (int i = 1, j = 0; i < n; i++)
+            {
+                int bit = n >> 1;
+                for (; j & bit; bit >>= 1)
+                    j ^= bit;
+                j ^= bit;
+
+                if (i < j)
+                    std::swap(a[i], a[j]);
+            }
+
+            LimbVector w(n / 2 + 1);
+            const int chunks = (limbs_go_parallel(n) ? limbs_threads() : 1);
+            for (int len = 2; len <= n; len <<= 1)
+            {
+                limb_t wlen = pow(G, (P - 1) / len);
+                if (inverse)
+                    wlen = pow(wlen, P - 2);
+
+                const int half = len / 2;
+                w[0] = 1;
+                for (int j = 1; j < half; j++)
+                    w[j] = mul(w[j - 1], wlen);
+
+                //The n / 2 butterflies of a stage are independent, so
+                //a long transform splits each stage between threads.
+                if (chunks == 1)
+                    butterflies(a, w.data(), half, 0, n / 2);
+                else
+                {
+                    std::vector<std::function<void()> > tasks;
+                    for (int c = 0; c < chunks; c++)
+                    {
+                        const int lo = static_cast<dlimb_t>(n / 2) * c / chunks,
+                            hi = static_cast<dlimb_t>(n / 2) * (c + 1) / chunks;
+                        tasks.push_back([=, &w]() {
+                            butterflies(a, w.data(), half, lo, hi);
+                        });
+                    }
+                    limbs_parallel(tasks);
+                }
+            }
+
+            if (inverse)
+            {
+                limb_t n_inv = pow(n, P - 2);
+                for (int i = 0; i < n; i++)
+                    a[i] = mul(a[i], n_inv);
+            }
+
+            return;
+        }
+
+        //out gets the n coefficients of a * b modulo P.
+        static void convolve(LimbVector & out,
+                             const limb_t * a, const int an,
+                             const limb_t * b, const int bn,
+                             const int n)
+        {
+            out.assign(n, 0);
+            for (int i = 0; i < an; i++)
+                out[i] = a[i] % P;
+
+            //Squaring only needs the one forward transform.
+            if (a == b && an == bn)
+            {
+                transform(out.data(), n, false);
+                for (int i = 0; i < n; i++)
+                    out[i] = mul(out[i], out[i]);
+            }
+
+            else
+            {
+                LimbVector t(n, 0);
+                for (int i = 0; i < bn; i++)
+                    t[i] = b[i] % P;
+
+                limbs_invoke(limbs_go_parallel(bn),
+                             [&]() { transform(out.data(), n, false); },
+                             [&]() { transform(t.data(), n, false); });
+
+                for (int i = 0; i < n; i++)
+                    out[i] = mul(out[i], t[i]);
+            }
+
+            transform(out.data(), n, true);
+
+            return;
+        }
+    };
+
+    //Each prime is k * 2^m + 1, so supports transforms up to 2^m.
+    typedef NttPrime<2013265921, 31> Prime1; //15 * 2^27 + 1
+    typedef NttPrime<469762049, 3>   Prime2; //7 * 2^26 + 1
+    typedef NttPrime<754974721, 11>  Prime3; //45 * 2^24 + 1
+}
+
+
+void limbs_mul_ntt(limb_t * r, const limb_t * a, const int an,
+                   const limb_t * b, const int bn)
+{
+    int n = 1;
+    while (n < an + bn - 1)
+        n <<= 1;
+
+    //One convolution per prime, independent of each other.
+    LimbVector c1, c2, c3;
+    limbs_invoke(limbs_go_parallel(bn),
+                 [&]() { Prime1::convolve(c1, a, an, b, bn, n); },
+                 [&]() { Prime2::convolve(c2, a, an, b, bn, n); },
+                 [&]() { Prime3::convolve(c3, a, an, b, bn, n); });
+
+    //Garner's algorithm: x = v1 + v2 * p1 + v3 * p1 * p2 with
+    //each v reduced by its own prime.
+    const limb_t p1 = Prime1::MOD, p2 = Prime2::MOD;
+    const limb_t inv_p1_mod_p2 = Prime2::pow(p1 % p2, p2 - 2),
+        inv_p1_mod_p3 = Prime3::pow(p1 % Prime3::MOD, Prime3::MOD - 2),
+        inv_p2_mod_p3 = Prime3::pow(p2 % Prime3::MOD, Prime3::MOD - 2);
+    const dlimb_t p1p2 = static_cast<dlimb_t>(p1) * p2;
+    const dlimb_t p1p2_lo = p1p2 & 0xFFFFFFFF, p1p2_hi = p1p2 >> LIMB_BITS;
+
+    dlimb_t carry = 0;
+    for (int i = 0; i < an + bn; i++)
+    {
+        if (i >= an + bn - 1)
+        {
+            r[i] = static_cast<limb_t>(carry);
+            carry >>= LIMB_BITS;
+            continue;
+        }
+
+        limb_t v1 = c1[i];
+        limb_t v2 = Prime2::mul(Prime2::sub(c2[i], v1 % p2), inv_p1_mod_p2);
+        limb_t v3 = Prime3::mul(Prime3::sub(c3[i], v1 % Prime3::MOD),
+                                inv_p1_mod_p3);
+        v3 = Prime3::mul(Prime3::sub(v3, v2 % Prime3::MOD), inv_p2_mod_p3);
+
+        //x + carry, 32 bits at a time. low is v1 + v2 * p1 < p1 * p2.
+        dlimb_t low = v1 + static_cast<dlimb_t>(v2) * p1;
+        dlimb_t v3_lo = v3 * p1p2_lo;
+        dlimb_t lo = (low & 0xFFFFFFFF) + (v3_lo & 0xFFFFFFFF)
+            + (carry & 0xFFFFFFFF);
+        carry = (low >> LIMB_BITS) + (v3_lo >> LIMB_BITS)
+            + (carry >> LIMB_BITS) + v3 * p1p2_hi + (lo >> LIMB_BITS);
+
+        r[i] = static_cast<limb_t>(lo);
+    }
+
+    return;
+}
@@ -0,0 +1,1032 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbOps.cpp
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+#include "LongIntStats.h"
+#include "LimbThreads.h"
+
+#include <vector>
+#include <algorithm>
+
+//Use the processor's add-with-carry / subtract-with-borrow
+//instructions when we know how to ask for them.
+#if defined(__x86_64__) || defined(_M_X64) || \
+    defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define LIMBS_NATIVE_CARRY
+#endif
+
+namespace
+{
+    //carry is both the incoming and outgoing carry (0 or 1).
+    inline
+    limb_t addc(const limb_t a, const limb_t b, unsigned char & carry)
+    {
+#ifdef LIMBS_NATIVE_CARRY
+        unsigned int r;
+        carry = _addcarry_u32(carry, a, b, &r);
+        return r;
+#else
+        dlimb_t s = static_cast<dlimb_t>(a) + b + carry;
+        carry = static_cast<unsigned char>(s >> LIMB_BITS);
+        return static_cast<limb_t>(s);
+#endif
+    }
+
+    //borrow is both the incoming and outgoing borrow (0 or 1).
+    inline
+    limb_t subb(const limb_t a, const limb_t b, unsigned char & borrow)
+    {
+#ifdef LIMBS_NATIVE_CARRY
+        unsigned int r;
+        borrow = _subborrow_u32(borrow, a, b, &r);
+        return r;
+#else
+        dlimb_t d = static_cast<dlimb_t>(a) - b - borrow;
+        borrow = static_cast<unsigned char>((d >> LIMB_BITS) & 1);
+        return static_cast<limb_t>(d);
+#endif
+    }
+
+    //XXH64's primes, for limbs_hash.
+    const std::uint64_t HASH_P1 = 0x9E3779B185EBCA87ULL;
+    const std::uint64_t HASH_P2 = 0xC2B2AE3D27D4EB4FULL;
+    const std::uint64_t HASH_P3 = 0x165667B19E3779F9ULL;
+    const std::uint64_t HASH_P4 = 0x85EBCA77C2B2AE63ULL;
+    const std::uint64_t HASH_P5 = 0x27D4EB2F165667C5ULL;
+
+    inline
+    std::uint64_t rotl64(const std::uint64_t x, const int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline
+    std::uint64_t hash_round(std::uint64_t acc, const std::uint64_t w)
+    {
+        acc += w * HASH_P2;
+        return rotl64(acc, 31) * HASH_P1;
+    }
+
+    //Limbs 2i and 2i + 1 as one little endian 64-bit word.
+    inline
+    std::uint64_t hash_word(const limb_t * a, const int i)
+    {
+        return a[2 * i] | static_cast<std::uint64_t>(a[2 * i + 1]) << LIMB_BITS;
+    }
+}
+
+
+LimbThresholds limb_thresholds = { 32, 256, 6144, 128, 32, 320, 2400, 256, 1024 };
+
+
+int limbs_normalize(const limb_t * a, int n)
+{
+    while (n > 0 && a[n - 1] == 0)
+        n--;
+
+    return n;
+}
+
+
+int limbs_cmp(const limb_t * a, const int an,
+              const limb_t * b, const int bn)
+{
+    if (an != bn)
+        return (an > bn ? 1 : -1);
+
+    for (int i = an - 1; i >= 0; i--)
+        if (a[i] != b[i])
+            return (a[i] > b[i] ? 1 : -1);
+
+    return 0;
+}
+
+
+limb_t limbs_add_n(limb_t * r, const limb_t * a, const limb_t * b,
+                   const int n)
+{
+    //Vectors where available, for whatever the vector kernel
+    //leaves at the end the scalar loop.
+    limb_t c = 0;
+    int i = (n >= LIMBS_SIMD_MIN ? limbs_add_n_simd(r, a, b, n, c) : 0);
+
+    unsigned char carry = static_cast<unsigned char>(c);
+    for (; i < n; i++)
+        r[i] = addc(a[i], b[i], carry);
+
+    return carry;
+}
+
+
+limb_t limbs_sub_n(limb_t * r, const limb_t * a, const limb_t * b,
+                   const int n)
+{
+    limb_t c = 0;
+    int i = (n >= LIMBS_SIMD_MIN ? limbs_sub_n_simd(r, a, b, n, c) : 0);
+
+    unsigned char borrow = static_cast<unsigned char>(c);
+    for (; i < n; i++)
+        r[i] = subb(a[i], b[i], borrow);
+
+    return borrow;
+}
+
+
+limb_t limbs_add(limb_t * r, const limb_t * a, const int an,
+                 const limb_t * b, const int bn)
+{
+    limb_t carry = limbs_add_n(r, a, b, bn);
+
+    return limbs_add_1(r + bn, a + bn, an - bn, carry);
+}
+
+
+limb_t limbs_sub(limb_t * r, const limb_t * a, const int an,
+                 const limb_t * b, const int bn)
+{
+    limb_t borrow = limbs_sub_n(r, a, b, bn);
+
+    return limbs_sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+
+limb_t limbs_add_1(limb_t * r, const limb_t * a, const int n,
+                   limb_t b)
+{
+    int i = 0;
+
+    //Only walk as far as the carry goes, then copy.
+    for (; i < n && b != 0; i++)
+    {
+        r[i] = a[i] + b;
+        b = (r[i] < b ? 1 : 0);
+    }
+
+    if (r != a)
+        for (; i < n; i++)
+            r[i] = a[i];
+
+    return b;
+}
+
+
+limb_t limbs_sub_1(limb_t * r, const limb_t * a, const int n,
+                   limb_t b)
+{
+    int i = 0;
+
+    //Only walk as far as the borrow goes, then copy.
+    for (; i < n && b != 0; i++)
+    {
+        limb_t x = a[i];
+        r[i] = x - b;
+        b = (x < b ? 1 : 0);
+    }
+
+    if (r != a)
+        for (; i < n; i++)
+            r[i] = a[i];
+
+    return b;
+}
+
+
+limb_t limbs_mul_1(limb_t * r, const limb_t * a, const int n,
+                   const limb_t b)
+{
+    dlimb_t carry = 0;
+    for (int i = 0; i < n; i++)
+    {
+        carry += static_cast<dlimb_t>(a[i]) * b;
+        r[i] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+    }
+
+    return static_cast<limb_t>(carry);
+}
+
+
+limb_t limbs_addmul_1(limb_t * r, const limb_t * a, const int n,
+                      const limb_t b)
+{
+    //r[i] + a[i] * b + carry always fits in a dlimb_t.
+    dlimb_t carry = 0;
+    for (int i = 0; i < n; i++)
+    {
+        carry += static_cast<dlimb_t>(a[i]) * b + r[i];
+        r[i] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+    }
+
+    return static_cast<limb_t>(carry);
+}
+
+
+limb_t limbs_submul_1(limb_t * r, const limb_t * a, const int n,
+                      const limb_t b)
+{
+    dlimb_t borrow = 0;
+    for (int i = 0; i < n; i++)
+    {
+        borrow += static_cast<dlimb_t>(a[i]) * b;
+        limb_t lo = static_cast<limb_t>(borrow), x = r[i];
+        r[i] = x - lo;
+        borrow = (borrow >> LIMB_BITS) + (x < lo ? 1 : 0);
+    }
+
+    return static_cast<limb_t>(borrow);
+}
+
+
+limb_t limbs_lshift(limb_t * r, const limb_t * a, const int n,
+                    const unsigned s)
+{
+    //Walk down so r may be a.
+    limb_t out = (n > 0 ? a[n - 1] >> (LIMB_BITS - s) : 0);
+    for (int i = n - 1; i >= 0; i--)
+        r[i] = (a[i] << s) | (i > 0 ? a[i - 1] >> (LIMB_BITS - s) : 0);
+
+    return out;
+}
+
+
+limb_t limbs_rshift(limb_t * r, const limb_t * a, const int n,
+                    const unsigned s)
+{
+    //Walk up so r may be a.
+    limb_t out = (n > 0 ? a[0] << (LIMB_BITS - s) : 0);
+    for (int i = 0; i < n; i++)
+        r[i] = (a[i] >> s) | (i + 1 < n ? a[i + 1] << (LIMB_BITS - s) : 0);
+
+    return out;
+}
+
+
+void limbs_and_n(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n)
+{
+    for (int i = 0; i < n; i++)
+        r[i] = a[i] & b[i];
+
+    return;
+}
+
+
+void limbs_ior_n(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n)
+{
+    for (int i = 0; i < n; i++)
+        r[i] = a[i] | b[i];
+
+    return;
+}
+
+
+void limbs_xor_n(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n)
+{
+    for (int i = 0; i < n; i++)
+        r[i] = a[i] ^ b[i];
+
+    return;
+}
+
+
+void limbs_com(limb_t * r, const limb_t * a, const int n)
+{
+    for (int i = 0; i < n; i++)
+        r[i] = ~a[i];
+
+    return;
+}
+
+
+std::uint64_t limbs_hash(const limb_t * a, const int n,
+                         const std::uint64_t seed)
+{
+    const int words = n / 2;
+    int i = 0;
+    std::uint64_t h;
+
+    if (words >= 4)
+    {
+        std::uint64_t v[4] = { seed + HASH_P1 + HASH_P2, seed + HASH_P2,
+                               seed, seed - HASH_P1 };
+        for (; i + 4 <= words; i += 4)
+            for (int j = 0; j < 4; j++)
+                v[j] = hash_round(v[j], hash_word(a, i + j));
+
+        h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) +
+            rotl64(v[3], 18);
+        for (int j = 0; j < 4; j++)
+            h = (h ^ hash_round(0, v[j])) * HASH_P1 + HASH_P4;
+    }
+    else
+        h = seed + HASH_P5;
+
+    h += static_cast<std::uint64_t>(n) * sizeof(limb_t);
+
+    for (; i < words; i++)
+        h = rotl64(h ^ hash_round(0, hash_word(a, i)), 27) * HASH_P1 + HASH_P4;
+
+    if (n % 2 == 1)
+        h = rotl64(h ^ a[n - 1] * HASH_P1, 23) * HASH_P2 + HASH_P3;
+
+    //Final avalanche, so every input bit reaches every output bit.
+    h ^= h >> 33;
+    h *= HASH_P2;
+    h ^= h >> 29;
+    h *= HASH_P3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+
+int limbs_popcount(const limb_t * a, const int n)
+{
+    //Count in parallel within each limb: pairs, then nibbles,
+    //then add the bytes with one multiply.
+    int count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        limb_t x = a[i];
+        x = x - ((x >> 1) & 0x55555555);
+        x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+        x = (x + (x >> 4)) & 0x0F0F0F0F;
+        count += static_cast<limb_t>(x * 0x01010101) >> 24;
+    }
+
+    return count;
+}
+
+
+limb_t limbs_divrem_1(limb_t * q, const limb_t * a, const int n,
+                      const limb_t d)
+{
+    dlimb_t rem = 0;
+    for (int i = n - 1; i >= 0; i--)
+    {
+        rem = (rem << LIMB_BITS) | a[i];
+        q[i] = static_cast<limb_t>(rem / d);
+        rem %= d;
+    }
+
+    return static_cast<limb_t>(rem);
+}
+
+
+namespace
+{
+    void mul_any(limb_t *, const limb_t *, int, const limb_t *, int);
+
+
+    void mul_basecase(limb_t * r, const limb_t * a, const int an,
+                      const limb_t * b, const int bn)
+    {
+        //Schoolbook, one row per limb of b.
+        r[an] = limbs_mul_1(r, a, an, b[0]);
+        for (int j = 1; j < bn; j++)
+            r[an + j] = limbs_addmul_1(r + j, a, an, b[j]);
+
+        return;
+    }
+
+
+    //mul_unbalanced with the pieces multiplied at the same time.
+    //Even pieces go straight into r, where they do not overlap, and
+    //odd ones into their own space to be added in after.
+    void mul_unbalanced_parallel(limb_t * r, const limb_t * a,
+                                 const int an, const limb_t * b,
+                                 const int bn)
+    {
+        const int pieces = (an + bn - 1) / bn;
+        LimbVector odd(pieces / 2 * 2 * bn);
+        std::vector<std::function<void()> > tasks;
+
+        std::fill(r, r + an + bn, 0);
+        for (int k = 0; k < pieces; k++)
+        {
+            const int i = k * bn, len = std::min(bn, an - i);
+            limb_t * out = (k % 2 == 0 ? r + i : odd.data() + (k / 2) * 2 * bn);
+            tasks.push_back([=]() { mul_any(out, a + i, len, b, bn); });
+        }
+        limbs_parallel(tasks);
+
+        for (int k = 1; k < pieces; k += 2)
+        {
+            const int i = k * bn, len = std::min(bn, an - i);
+            limbs_add(r + i, r + i, an + bn - i,
+                      odd.data() + (k / 2) * 2 * bn, len + bn);
+        }
+
+        return;
+    }
+
+
+    //a is at least twice as long as b. Cut a into pieces the size
+    //of b so each partial product is balanced.
+    void mul_unbalanced(limb_t * r, const limb_t * a, const int an,
+                        const limb_t * b, const int bn)
+    {
+        if (limbs_go_parallel(bn))
+        {
+            mul_unbalanced_parallel(r, a, an, b, bn);
+            return;
+        }
+
+        LimbVector t(2 * bn);
+
+        limbs_mul(r, a, bn, b, bn);
+        for (int i = bn; i < an; i += bn)
+        {
+            int len = std::min(bn, an - i);
+            mul_any(t.data(), a + i, len, b, bn);
+
+            //r[i..i + bn) already holds the top of the last piece.
+            limb_t carry = limbs_add_n(r + i, r + i, t.data(), bn);
+            for (int j = bn; j < len + bn; j++)
+            {
+                dlimb_t s = static_cast<dlimb_t>(t[j]) + carry;
+                r[i + j] = static_cast<limb_t>(s);
+                carry = static_cast<limb_t>(s >> LIMB_BITS);
+            }
+        }
+
+        return;
+    }
+
+
+    /*
+      Karatsuba, bn <= an < 2 * bn. With B = 2^32 and a split at
+      h limbs:
+          a = a1 * B^h + a0,  b = b1 * B^h + b0
+          a * b = z2 * B^2h + z1 * B^h + z0
+      where z0 = a0 * b0, z2 = a1 * b1 and
+          z1 = (a0 + a1)(b0 + b1) - z0 - z2.
+      b1 may be empty when bn == h.
+    */
+    void mul_karatsuba(limb_t * r, const limb_t * a, const int an,
+                       const limb_t * b, const int bn)
+    {
+        const int h = (an + 1) / 2;
+        const int n = an + bn;
+
+        LimbVector scratch(4 * h + 4);
+        limb_t * sa = scratch.data();
+        limb_t * sb = sa + h + 1;
+        limb_t * z1 = sb + h + 1;
+
+        sa[h] = limbs_add(sa, a, h, a + h, an - h);
+        sb[h] = limbs_add(sb, b, h, b + h, bn - h);
+        const int san = limbs_normalize(sa, h + 1),
+            sbn = limbs_normalize(sb, h + 1);
+
+        //z0 and z2 go straight into their place in r. The three
+        //products are independent.
+        limbs_invoke(limbs_go_parallel(bn),
+                     [=]() { mul_any(r, a, h, b, h); },
+                     [=]() { mul_any(r + 2 * h, a + h, an - h, b + h, bn - h); },
+                     [=]() { mul_any(z1, sa, san, sb, sbn); });
+
+        int z1n = 2 * h + 2;
+        limbs_sub(z1, z1, z1n, r, 2 * h);
+        limbs_sub(z1, z1, z1n, r + 2 * h, n - 2 * h);
+        z1n = limbs_normalize(z1, z1n);
+
+        limbs_add(r + h, r + h, n - h, z1, z1n);
+
+        return;
+    }
+
+
+    //A signed number for Toom-3's evaluation points, some of which
+    //go negative.
+    struct SignedLimbs
+    {
+        LimbVector m;
+        bool neg;
+    };
+
+
+    SignedLimbs make_signed(const limb_t * a, const int n)
+    {
+        SignedLimbs ret;
+        ret.m.assign(a, a + limbs_normalize(a, n));
+        ret.neg = false;
+
+        return ret;
+    }
+
+
+    SignedLimbs signed_add(const SignedLimbs & x, const SignedLimbs & y,
+                           const bool negate_y = false)
+    {
+        const bool y_neg = (y.neg != negate_y);
+        const SignedLimbs * big = &x, * small = &y;
+        bool big_neg = x.neg, small_neg = y_neg;
+
+        if (limbs_cmp(x.m.data(), x.m.size(), y.m.data(), y.m.size()) < 0)
+        {
+            std::swap(big, small);
+            std::swap(big_neg, small_neg);
+        }
+
+        SignedLimbs ret;
+        ret.m.resize(big->m.size() + 1);
+        ret.neg = big_neg;
+
+        if (big_neg == small_neg)
+            ret.m.back() = limbs_add(ret.m.data(), big->m.data(), big->m.size(),
+                                     small->m.data(), small->m.size());
+        else
+            limbs_sub(ret.m.data(), big->m.data(), big->m.size(),
+                      small->m.data(), small->m.size());
+
+        ret.m.resize(limbs_normalize(ret.m.data(), ret.m.size()));
+        if (ret.m.empty())
+            ret.neg = false;
+
+        return ret;
+    }
+
+
+    SignedLimbs signed_mul(const SignedLimbs & x, const SignedLimbs & y)
+    {
+        SignedLimbs ret;
+        ret.neg = (x.neg != y.neg);
+        ret.m.resize(x.m.size() + y.m.size());
+        mul_any(ret.m.data(), x.m.data(), x.m.size(), y.m.data(), y.m.size());
+        ret.m.resize(limbs_normalize(ret.m.data(), ret.m.size()));
+        if (ret.m.empty())
+            ret.neg = false;
+
+        return ret;
+    }
+
+
+    //x * 2.
+    SignedLimbs & signed_twice(SignedLimbs & x)
+    {
+        limb_t out = (x.m.empty() ? 0 : limbs_lshift(x.m.data(), x.m.data(),
+                                                       x.m.size(), 1));
+        if (out != 0)
+            x.m.push_back(out);
+
+        return x;
+    }
+
+
+    //x / d where d divides x exactly.
+    SignedLimbs & signed_divexact(SignedLimbs & x, const limb_t d)
+    {
+        limbs_divrem_1(x.m.data(), x.m.data(), x.m.size(), d);
+        x.m.resize(limbs_normalize(x.m.data(), x.m.size()));
+
+        return x;
+    }
+
+
+    //Split a into three k limb pieces, the top one may be short
+    //or empty.
+    void toom3_split(const limb_t * a, const int an, const int k,
+                     SignedLimbs piece[3])
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            int lo = std::min(an, i * k);
+            int hi = (i == 2 ? an : std::min(an, (i + 1) * k));
+            piece[i] = make_signed(a + lo, hi - lo);
+        }
+
+        return;
+    }
+
+
+    //Values of the polynomial p(x) = a2 x^2 + a1 x + a0 at
+    //1, -1 and -2.
+    void toom3_evaluate(const SignedLimbs a[3], SignedLimbs & p1,
+                        SignedLimbs & pm1, SignedLimbs & pm2)
+    {
+        SignedLimbs p0 = signed_add(a[0], a[2]);
+        p1 = signed_add(p0, a[1]);
+        pm1 = signed_add(p0, a[1], true);
+        pm2 = signed_add(pm1, a[2]);
+        signed_twice(pm2);
+        pm2 = signed_add(pm2, a[0], true);
+
+        return;
+    }
+
+
+    //Add the non-negative x into r at offset limbs.
+    void add_at(limb_t * r, const int n, const int offset,
+                const SignedLimbs & x)
+    {
+        if (!x.m.empty())
+            limbs_add(r + offset, r + offset, n - offset,
+                      x.m.data(), x.m.size());
+
+        return;
+    }
+
+
+    /*
+      Toom-3 (Toom-Cook with three pieces), bn <= an < 2 * bn.
+      Both operands are treated as quadratics in B^k, evaluated at
+      0, 1, -1, -2 and infinity, multiplied pointwise and the
+      product's five coefficients recovered with Bodrato's
+      interpolation sequence.
+    */
+    void mul_toom3(limb_t * r, const limb_t * a, const int an,
+                   const limb_t * b, const int bn)
+    {
+        const int k = (an + 2) / 3;
+        const int n = an + bn;
+
+        SignedLimbs ap[3], bp[3];
+        toom3_split(a, an, k, ap);
+        toom3_split(b, bn, k, bp);
+
+        SignedLimbs a1, am1, am2, b1, bm1, bm2;
+        toom3_evaluate(ap, a1, am1, am2);
+        toom3_evaluate(bp, b1, bm1, bm2);
+
+        SignedLimbs r0, r1, rm1, rm2, r4;
+        limbs_invoke(limbs_go_parallel(bn),
+                     [&]() { r0 = signed_mul(ap[0], bp[0]); },
+                     [&]() { r1 = signed_mul(a1, b1); },
+                     [&]() { rm1 = signed_mul(am1, bm1); },
+                     [&]() { rm2 = signed_mul(am2, bm2); },
+                     [&]() { r4 = signed_mul(ap[2], bp[2]); });
+
+        SignedLimbs r3 = signed_add(rm2, r1, true);
+        signed_divexact(r3, 3);
+        r1 = signed_add(r1, rm1, true);
+        signed_divexact(r1, 2);
+        SignedLimbs r2 = signed_add(rm1, r0, true);
+        r3 = signed_add(r2, r3, true);
+        signed_divexact(r3, 2);
+        SignedLimbs twice_r4 = r4;
+        r3 = signed_add(r3, signed_twice(twice_r4));
+        r2 = signed_add(r2, r1);
+        r2 = signed_add(r2, r4, true);
+        r1 = signed_add(r1, r3, true);
+
+        //Every coefficient is now non-negative.
+        std::fill(r, r + n, 0);
+        add_at(r, n, 0, r0);
+        add_at(r, n, k, r1);
+        add_at(r, n, 2 * k, r2);
+        add_at(r, n, 3 * k, r3);
+        add_at(r, n, 4 * k, r4);
+
+        return;
+    }
+
+
+    //limbs_mul without its preconditions: either operand may be
+    //the longer one, and either may be empty or have high zeros.
+    void mul_any(limb_t * r, const limb_t * a, int an,
+                 const limb_t * b, int bn)
+    {
+        if (an < bn)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+
+        if (bn == 0)
+            std::fill(r, r + an, 0);
+        else
+            limbs_mul(r, a, an, b, bn);
+
+        return;
+    }
+}
+
+
+void limbs_mul(limb_t * r, const limb_t * a, const int an,
+               const limb_t * b, const int bn)
+{
+    if (bn < limb_thresholds.karatsuba)
+    {
+        StatTimer timer(TIER_MUL_BASECASE);
+        mul_basecase(r, a, an, b, bn);
+    }
+    else if (bn >= limb_thresholds.ntt && an + bn <= LIMBS_NTT_MAX)
+    {
+        StatTimer timer(TIER_MUL_NTT);
+        limbs_mul_ntt(r, a, an, b, bn);
+    }
+    else if (an >= 2 * bn)
+    {
+        StatTimer timer(TIER_MUL_UNBALANCED);
+        mul_unbalanced(r, a, an, b, bn);
+    }
+    else if (bn < limb_thresholds.toom3)
+    {
+        StatTimer timer(TIER_MUL_KARATSUBA);
+        mul_karatsuba(r, a, an, b, bn);
+    }
+    else
+    {
+        StatTimer timer(TIER_MUL_TOOM3);
+        mul_toom3(r, a, an, b, bn);
+    }
+
+    return;
+}
+
+
+limb_t limbs_addmul(limb_t * r, const int rn, const limb_t * a,
+                    const int an, const limb_t * b, const int bn)
+{
+    //Small enough for schoolbook: run the rows straight into r
+    //instead of building the product first.
+    if (bn < limb_thresholds.karatsuba)
+    {
+        limb_t carry = 0;
+        for (int j = 0; j < bn; j++)
+        {
+            limb_t c = limbs_addmul_1(r + j, a, an, b[j]);
+            carry += limbs_add_1(r + j + an, r + j + an, rn - j - an, c);
+        }
+
+        return carry;
+    }
+
+    LimbVector prod(an + bn);
+    limbs_mul(prod.data(), a, an, b, bn);
+
+    return limbs_add(r, r, rn, prod.data(), an + bn);
+}
+
+
+namespace
+{
+    typedef LimbVector Limbs;
+
+
+    int leading_zeros(limb_t x)
+    {
+        int n = 0;
+        for (limb_t bit = limb_t(1) << (LIMB_BITS - 1); !(x & bit); bit >>= 1)
+            n++;
+
+        return n;
+    }
+
+
+    /*
+      Knuth's Algorithm D (TAOCP vol. 2, 4.3.1). v has vn >= 2 limbs
+      with its top bit set and u has un > vn limbs. q gets the
+      un - vn quotient limbs and u is left holding the remainder
+      in its low vn limbs.
+    */
+    void divrem_knuth(limb_t * q, limb_t * u, const int un,
+                      const limb_t * v, const int vn)
+    {
+        const dlimb_t B = dlimb_t(1) << LIMB_BITS;
+        const limb_t v1 = v[vn - 1], v2 = v[vn - 2];
+
+        for (int j = un - vn - 1; j >= 0; j--)
+        {
+            //Estimate the quotient limb from the top two limbs, it is
+            //at most two too big after the correction loop.
+            dlimb_t num = (static_cast<dlimb_t>(u[j + vn]) << LIMB_BITS)
+                | u[j + vn - 1];
+            dlimb_t qhat = num / v1, rhat = num % v1;
+
+            while (qhat >= B ||
+                   qhat * v2 > ((rhat << LIMB_BITS) | u[j + vn - 2]))
+            {
+                qhat--;
+                rhat += v1;
+                if (rhat >= B)
+                    break;
+            }
+
+            //u -= qhat * v, and add v back if that went negative.
+            limb_t borrow = limbs_submul_1(u + j, v, vn,
+                                           static_cast<limb_t>(qhat));
+            limb_t top = u[j + vn];
+            u[j + vn] = top - borrow;
+            if (top < borrow)
+            {
+                qhat--;
+                u[j + vn] += limbs_add_n(u + j, u + j, v, vn);
+            }
+
+            q[j] = static_cast<limb_t>(qhat);
+        }
+
+        return;
+    }
+
+
+    void div2n1n(limb_t *, Limbs &, const limb_t *, const limb_t *, const int);
+
+
+    /*
+      Burnikel-Ziegler 3n/2n step. a12 has 2h limbs, a3 has h limbs
+      and b = b1 * B^h + b2 has 2h limbs with its top bit set. q gets
+      h limbs and r gets the remainder.
+    */
+    void div3n2n(limb_t * q, Limbs & r, const limb_t * a12,
+                 const limb_t * a3, const limb_t * b, const int h)
+    {
+        const limb_t * b1 = b + h, * b2 = b;
+        Limbs r1;
+
+        //a12 / b1 would not fit in h limbs, the quotient is B^h - 1.
+        if (limbs_cmp(a12 + h, h, b1, h) == 0)
+        {
+            for (int i = 0; i < h; i++)
+                q[i] = ~limb_t(0);
+            r1.assign(a12, a12 + h);
+            r1.push_back(limbs_add_n(r1.data(), r1.data(), b1, h));
+        }
+
+        else
+            div2n1n(q, r1, a12, b1, h);
+
+        //r = r1 * B^h + a3 - q * b2.
+        r.assign(a3, a3 + h);
+        r.insert(r.end(), r1.begin(), r1.end());
+
+        Limbs t(2 * h);
+        limbs_mul(t.data(), q, h, b2, h);
+
+        int rn = limbs_normalize(r.data(), r.size()),
+            tn = limbs_normalize(t.data(), t.size());
+
+        if (limbs_cmp(r.data(), rn, t.data(), tn) >= 0)
+        {
+            limbs_sub(r.data(), r.data(), rn, t.data(), tn);
+        }
+
+        //It went negative. Turn r into the deficit t - r and add b
+        //back until it is covered; this takes at most two tries.
+        else
+        {
+            limbs_sub(t.data(), t.data(), tn, r.data(), rn);
+            tn = limbs_normalize(t.data(), tn);
+            do
+            {
+                limbs_sub_1(q, q, h, 1);
+                if (limbs_cmp(t.data(), tn, b, 2 * h) <= 0)
+                {
+                    r.assign(b, b + 2 * h);
+                    limbs_sub(r.data(), r.data(), 2 * h, t.data(), tn);
+                    break;
+                }
+                limbs_sub(t.data(), t.data(), tn, b, 2 * h);
+                tn = limbs_normalize(t.data(), tn);
+            } while (true);
+        }
+
+        r.resize(2 * h);
+
+        return;
+    }
+
+
+    /*
+      Burnikel-Ziegler 2n/1n step. a has 2n limbs, b has n limbs
+      with its top bit set and a < B^n * b. q gets n limbs and r gets
+      the n limb remainder.
+    */
+    void div2n1n(limb_t * q, Limbs & r, const limb_t * a,
+                 const limb_t * b, const int n)
+    {
+        //Knuth needs at least two divisor limbs, so never
+        //split below four.
+        if (n < limb_thresholds.div_dc || n < 4)
+        {
+            Limbs u(a, a + 2 * n);
+            u.push_back(0);
+
+            Limbs q_full(n + 1);
+            divrem_knuth(q_full.data(), u.data(), 2 * n + 1, b, n);
+            std::copy(q_full.begin(), q_full.begin() + n, q);
+            r.assign(u.begin(), u.begin() + n);
+            return;
+        }
+
+        //The halves have to be even, so scale both by B when n is
+        //odd and scale the remainder back after.
+        if (n % 2 == 1)
+        {
+            Limbs a_pad(2 * n + 2, 0), b_pad(n + 1, 0);
+            std::copy(a, a + 2 * n, a_pad.begin() + 1);
+            std::copy(b, b + n, b_pad.begin() + 1);
+
+            Limbs q_pad(n + 1);
+            div2n1n(q_pad.data(), r, a_pad.data(), b_pad.data(), n + 1);
+            std::copy(q_pad.begin(), q_pad.begin() + n, q);
+            r.erase(r.begin());
+            return;
+        }
+
+        const int h = n / 2;
+        Limbs r1;
+        div3n2n(q + h, r1, a + n, a + h, b, h);
+
+        //r1 * B^h + the low h limbs of a.
+        Limbs a12(r1);
+        div3n2n(q, r, a12.data(), a, b, h);
+
+        return;
+    }
+
+
+    /*
+      Schoolbook division in base B^n, n = vn, with each step done
+      by div2n1n. v has its top bit set and u has un limbs.
+    */
+    void divrem_dc(limb_t * q, Limbs & rem, const limb_t * u, const int un,
+                   const limb_t * v, const int vn)
+    {
+        const int blocks = (un + vn - 1) / vn;
+        Limbs a(2 * vn);
+
+        rem.assign(vn, 0);
+        for (int k = blocks - 1; k >= 0; k--)
+        {
+            //a = rem * B^vn + block k of u.
+            int lo = k * vn, len = std::min(vn, un - lo);
+            std::fill(a.begin(), a.begin() + vn, 0);
+            std::copy(u + lo, u + lo + len, a.begin());
+            std::copy(rem.begin(), rem.end(), a.begin() + vn);
+
+            Limbs qk(vn);
+            div2n1n(qk.data(), rem, a.data(), v, vn);
+
+            //Quotient limbs past un - vn are always zero.
+            for (int i = 0; i < vn && lo + i < un - vn; i++)
+                q[lo + i] = qk[i];
+        }
+
+        return;
+    }
+}
+
+
+void limbs_divrem(limb_t * q, limb_t * r, const limb_t * a,
+                  const int an, const limb_t * b, const int bn)
+{
+    if (bn == 1)
+    {
+        StatTimer timer(TIER_DIV_KNUTH);
+        r[0] = limbs_divrem_1(q, a, an, b[0]);
+        return;
+    }
+
+    //Scale both so the divisor's top bit is set, which keeps the
+    //quotient limb estimates close.
+    const unsigned s = leading_zeros(b[bn - 1]);
+    Limbs v(b, b + bn), u(a, a + an);
+    u.push_back(0);
+    if (s != 0)
+    {
+        limbs_lshift(v.data(), v.data(), bn, s);
+        u[an] = limbs_lshift(u.data(), u.data(), an, s);
+    }
+
+    //Knuth for small divisors or short quotients, where
+    //recursion buys nothing.
+    if (bn < limb_thresholds.div_dc || an - bn < limb_thresholds.div_dc)
+    {
+        StatTimer timer(TIER_DIV_KNUTH);
+        Limbs q_full(an - bn + 1);
+        divrem_knuth(q_full.data(), u.data(), an + 1, v.data(), bn);
+        std::copy(q_full.begin(), q_full.end(), q);
+        u.resize(bn);
+    }
+
+    else
+    {
+        StatTimer timer(TIER_DIV_BZ);
+        for (int i = 0; i < an - bn + 1; i++)
+            q[i] = 0;
+        Limbs rem;
+        divrem_dc(q, rem, u.data(), an + 1, v.data(), bn);
+        u.swap(rem);
+    }
+
+    //Scale the remainder back down.
+    if (s != 0)
+        limbs_rshift(r, u.data(), bn, s);
+    else
+        std::copy(u.begin(), u.begin() + bn, r);
+
+    return;
+}
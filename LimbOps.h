@@ -0,0 +1,200 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbOps.h
+
+/*
+  Low level routines that work on arrays of 32-bit limbs stored
+  least significant limb first. These are the building blocks
+  LongInt uses for its magnitude; they know nothing about signs.
+
+  Lengths are counted in limbs. Unless a routine says otherwise
+  the result array may be the same array as an input operand, but
+  it must not partially overlap one.
+*/
+
+#ifndef LIMB_OPS_H
+#define LIMB_OPS_H
+
+#include <cstdint>
+
+typedef std::uint32_t limb_t;
+typedef std::uint64_t dlimb_t;
+
+const int LIMB_BITS = 32;
+
+//Operand sizes, in limbs, where limbs_mul moves on to the next
+//algorithm. The smaller operand has to reach the threshold. These
+//are plain globals so they can be tuned for the machine at start
+//up.
+struct LimbThresholds
+{
+    int karatsuba; //Schoolbook below this.
+    int toom3;     //Karatsuba below this.
+    int ntt;       //Toom-3 below this.
+    int div_dc;    //Divisor length where limbs_divrem goes from
+                   //Knuth's algorithm D to Burnikel-Ziegler.
+    int radix_dc;  //Length where decimal conversion starts to
+                   //divide and conquer.
+    int redc;      //Odd modulus length where modular arithmetic
+                   //goes from Montgomery to Barrett reduction.
+    int gcd_dc;    //Length where GCD goes from Lehmer's algorithm
+                   //to half-GCD.
+    int hgcd;      //Length where half-GCD stops recursing and
+                   //finishes with Lehmer steps.
+    int parallel;  //Length where multiplication starts handing
+                   //its sub products to other threads.
+};
+
+extern LimbThresholds limb_thresholds;
+
+//How many threads a single multiplication may use, counting the
+//caller. Karatsuba's and Toom-3's sub products, the pieces of an
+//unbalanced product and the NTT's transforms are then spread over
+//a shared pool, and so is everything built on limbs_mul, division
+//included. The default of 1 keeps all work on the calling thread.
+//Do not change it while other threads are multiplying.
+void limbs_set_threads(const int);
+int limbs_threads();
+
+//Length of a with any high zero limbs dropped.
+int limbs_normalize(const limb_t *, int);
+
+//Compare two normalized magnitudes. Returns 1, 0 or -1.
+int limbs_cmp(const limb_t *, const int, const limb_t *, const int);
+
+//r = a + b for two n limb arrays, returns the carry out.
+limb_t limbs_add_n(limb_t *, const limb_t *, const limb_t *, const int);
+//r = a - b for two n limb arrays, returns the borrow out.
+limb_t limbs_sub_n(limb_t *, const limb_t *, const limb_t *, const int);
+
+//Vector kernels behind limbs_add_n and limbs_sub_n, using AVX2 or
+//AVX-512 when the processor has them. They take the carry or borrow
+//in and out through c, do as many limbs from the bottom as fit
+//whole vectors and return how many that was, 0 when there is no
+//vector unit to use. Only worth calling from LIMBS_SIMD_MIN limbs.
+int limbs_add_n_simd(limb_t *, const limb_t *, const limb_t *,
+                     const int, limb_t &);
+int limbs_sub_n_simd(limb_t *, const limb_t *, const limb_t *,
+                     const int, limb_t &);
+const int LIMBS_SIMD_MIN = 16;
+
+//r = a + b where a has an limbs, b has bn limbs and an >= bn.
+//r gets an limbs and the carry out is returned.
+limb_t limbs_add(limb_t *, const limb_t *, const int,
+                 const limb_t *, const int);
+//r = a - b where a has an limbs, b has bn limbs and an >= bn.
+//r gets an limbs and the borrow out is returned.
+limb_t limbs_sub(limb_t *, const limb_t *, const int,
+                 const limb_t *, const int);
+
+//r = a + b / a - b for a single limb b.
+limb_t limbs_add_1(limb_t *, const limb_t *, const int, const limb_t);
+limb_t limbs_sub_1(limb_t *, const limb_t *, const int, const limb_t);
+
+//r = a * b for a single limb b, returns the high limb.
+limb_t limbs_mul_1(limb_t *, const limb_t *, const int, const limb_t);
+//r += a * b for a single limb b, returns the high limb.
+limb_t limbs_addmul_1(limb_t *, const limb_t *, const int, const limb_t);
+//r -= a * b for a single limb b, returns the borrow limb.
+limb_t limbs_submul_1(limb_t *, const limb_t *, const int, const limb_t);
+
+//r = a << s / a >> s for 0 < s < LIMB_BITS. Returns the bits
+//shifted out, in the low bits for << and the high bits for >>.
+limb_t limbs_lshift(limb_t *, const limb_t *, const int, const unsigned);
+limb_t limbs_rshift(limb_t *, const limb_t *, const int, const unsigned);
+
+//r = a & b, a | b, a ^ b for two n limb arrays, and r = ~a. r may
+//be an input.
+void limbs_and_n(limb_t *, const limb_t *, const limb_t *, const int);
+void limbs_ior_n(limb_t *, const limb_t *, const limb_t *, const int);
+void limbs_xor_n(limb_t *, const limb_t *, const limb_t *, const int);
+void limbs_com(limb_t *, const limb_t *, const int);
+
+//Number of one bits in n limbs.
+int limbs_popcount(const limb_t *, const int);
+
+//Hash of n limbs with a seed. It is XXH64 of the limbs' little
+//endian bytes, so it comes out the same on every machine and in
+//every run. Four independent lanes take 32 bytes at a time, which
+//keeps the multipliers busy.
+std::uint64_t limbs_hash(const limb_t *, const int, const std::uint64_t);
+
+//q = a / d, returns a % d. q may be a.
+limb_t limbs_divrem_1(limb_t *, const limb_t *, const int, const limb_t);
+
+//r = a * b where an >= bn >= 1. r gets an + bn limbs and must
+//not be either input.
+void limbs_mul(limb_t *, const limb_t *, const int,
+               const limb_t *, const int);
+
+//r += a * b where an >= bn >= 1 and r has rn >= an + bn limbs.
+//Returns the carry out of r. r must not be either input.
+limb_t limbs_addmul(limb_t *, const int, const limb_t *, const int,
+                    const limb_t *, const int);
+
+//Longest product, an + bn, limbs_mul_ntt can do exactly.
+const int LIMBS_NTT_MAX = 1 << 24;
+
+//r = a * b by number theoretic transform for an, bn >= 1 and
+//an + bn <= LIMBS_NTT_MAX. r gets an + bn limbs and must not be
+//either input. limbs_mul calls this for large operands.
+void limbs_mul_ntt(limb_t *, const limb_t *, const int,
+                   const limb_t *, const int);
+
+//q = a / b and r = a % b where an >= bn >= 1 and the top limb of
+//b is non zero. q gets an - bn + 1 limbs, r gets bn limbs and
+//neither may be an input.
+void limbs_divrem(limb_t *, limb_t *, const limb_t *, const int,
+                  const limb_t *, const int);
+
+//Montgomery reduction modulo an odd n limb m, with R = 2^(32n).
+//limbs_mont_inv gives -1 / m mod 2^32 from the bottom limb of m.
+//limbs_redc sets r = t / R mod m for a 2n limb t < m * R, using t
+//as scratch. r gets n limbs and is less than m.
+limb_t limbs_mont_inv(const limb_t);
+void limbs_redc(limb_t *, limb_t *, const limb_t *, const int,
+                const limb_t);
+
+//Barrett reduction modulo an n limb m with a non zero top limb.
+//limbs_barrett_inv sets mu = 2^(64n) / m, which takes n + 2 limbs.
+//limbs_barrett_reduce sets r = t mod m for a 2n limb t, given mu
+//and limbs_barrett_scratch(n) limbs of scratch. r gets n limbs.
+void limbs_barrett_inv(limb_t *, const limb_t *, const int);
+int limbs_barrett_scratch(const int);
+void limbs_barrett_reduce(limb_t *, const limb_t *, const limb_t *,
+                          const int, const limb_t *, limb_t *);
+
+//gcd(a, b) for normalized an, bn >= 1 limbs. g needs min(an, bn)
+//limbs and the gcd's length is returned.
+int limbs_gcd(limb_t *, const limb_t *, const int,
+              const limb_t *, const int);
+//The same, plus the cofactor s with s * a + t * b = g for some t,
+//chosen so |s| <= b / (2g). s needs bn limbs and *sn gets its
+//length, negated if s is negative.
+int limbs_gcdext(limb_t *, limb_t *, int *, const limb_t *, const int,
+                 const limb_t *, const int);
+
+//floor(a^(1/k)) for normalized an >= 1 limbs and k >= 1. r needs
+//an / k + 1 limbs and the root's length is returned.
+int limbs_root(limb_t *, const limb_t *, const int, const int);
+
+//Text conversion, most significant digit first with no sign and
+//"0" for zero. Hex digits are lower case on output and either
+//case on input. No validation is done on input, s must hold only
+//digits of the base.
+//
+//*_size(n) is enough room for the text of n limbs, *_limbs(len)
+//is enough room for the value of len digits. The to_ routines
+//return the number of characters written and the from_ routines
+//return the normalized limb count.
+int limbs_dec_size(const int);
+int limbs_dec_limbs(const int);
+int limbs_to_dec(char *, const limb_t *, int);
+int limbs_from_dec(limb_t *, const char *, const int);
+
+int limbs_hex_size(const int);
+int limbs_hex_limbs(const int);
+int limbs_to_hex(char *, const limb_t *, int);
+int limbs_from_hex(limb_t *, const char *, const int);
+
+#endif
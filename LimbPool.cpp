@@ -0,0 +1,138 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbPool.cpp
+
+#include "LimbPool.h"
+#include "LongIntStats.h"
+
+namespace
+{
+    //Size classes step by quarters of a power of two, 8, 10, 12,
+    //14, 16, 20, ... up to LIMBS_POOL_MAX_BLOCK. Plain powers of
+    //two would waste more and line every block up on the same cache
+    //sets, which slows down routines working on several at once.
+    const int CLASSES = 53;
+
+    //A free block holds the link to the next one in its first
+    //limbs.
+    struct Block
+    {
+        Block * next;
+    };
+
+    //Plain thread locals, so they need no guard to reach and stay
+    //usable while other thread locals and statics are destroyed.
+    thread_local Block * free_list[CLASSES] = {};
+    thread_local int cached = 0;
+    thread_local bool exited = false;
+
+    //Frees the thread's lists when it exits. Only touched once a
+    //block is actually cached, so threads that never cache skip
+    //the exit handler.
+    struct Flush
+    {
+        ~Flush()
+        {
+            limbs_pool_release();
+            exited = true;
+            return;
+        }
+    };
+
+    thread_local Flush flush;
+
+    //Smallest class holding n limbs, as m << e for m from 4 to 7.
+    //Returns its index, or CLASSES if there is none.
+    inline
+    int size_class(const int n, int & size)
+    {
+        if (n <= LIMBS_POOL_MIN)
+        {
+            size = LIMBS_POOL_MIN;
+            return 0;
+        }
+
+        if (n > LIMBS_POOL_MAX_BLOCK)
+        {
+            size = n;
+            return CLASSES;
+        }
+
+        int e = 0;
+        while (((n - 1) >> e) >= 8)
+            e++;
+
+        int m = ((n - 1) >> e) + 1;
+        if (m == 8)
+        {
+            m = 4;
+            e++;
+        }
+
+        size = m << e;
+
+        return 4 * e + m - 8;
+    }
+}
+
+
+limb_t * limbs_alloc(int & n)
+{
+    int size = 0;
+    const int c = size_class(n, size);
+    n = size;
+    if (c < CLASSES && free_list[c] != nullptr)
+    {
+        Block * b = free_list[c];
+        free_list[c] = b->next;
+        cached -= n;
+        stats_alloc(n, true);
+
+        return reinterpret_cast<limb_t *>(b);
+    }
+
+    stats_alloc(n, false);
+
+    return new limb_t[n];
+}
+
+
+void limbs_free(limb_t * x, const int n)
+{
+    stats_free();
+
+    int size = 0;
+    const int c = size_class(n, size);
+    if (c == CLASSES || exited || cached + size > LIMBS_POOL_MAX_CACHED)
+    {
+        delete[] x;
+        return;
+    }
+
+    static_cast<void>(&flush);
+
+    Block * b = reinterpret_cast<Block *>(x);
+    b->next = free_list[c];
+    free_list[c] = b;
+    cached += size;
+
+    return;
+}
+
+
+void limbs_pool_release()
+{
+    for (int c = 0; c < CLASSES; c++)
+    {
+        while (free_list[c] != nullptr)
+        {
+            Block * b = free_list[c];
+            free_list[c] = b->next;
+            delete[] reinterpret_cast<limb_t *>(b);
+        }
+    }
+
+    cached = 0;
+
+    return;
+}
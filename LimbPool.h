@@ -0,0 +1,87 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbPool.h
+
+/*
+  Per thread recycling of limb blocks.
+
+  Arithmetic on big LongInts goes through a stream of short lived
+  limb arrays, the temporaries and the scratch space inside the limb
+  routines. Rather than handing each one back to the global heap,
+  which every thread has to share, a freed block goes on a free list
+  of the thread that freed it, and the next block of the same size
+  class that thread asks for comes straight back off it. No locks
+  are taken and in a steady state nothing reaches the heap.
+
+  Blocks are rounded up to size classes that step by quarters of a
+  power of two, 8, 10, 12, 14, 16, 20, 24, 28, 32, ... limbs, from
+  LIMBS_POOL_MIN up to LIMBS_POOL_MAX_BLOCK, so past the smallest
+  class a block wastes less than a fifth of itself. Blocks above
+  LIMBS_POOL_MAX_BLOCK limbs are not kept at all. Each thread keeps
+  at most LIMBS_POOL_MAX_CACHED limbs on its lists, counted at their
+  rounded sizes, so the pool never holds on to more than a megabyte
+  per thread. A thread's lists are freed when it exits, or earlier
+  with limbs_pool_release.
+
+  A block may be freed by a different thread than the one that
+  allocated it; it simply joins the other thread's lists.
+*/
+
+#ifndef LIMB_POOL_H
+#define LIMB_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+#include "LimbOps.h"
+
+const int LIMBS_POOL_MIN = 8;
+const int LIMBS_POOL_MAX_BLOCK = 1 << 16;
+const int LIMBS_POOL_MAX_CACHED = 1 << 18;
+
+//A block of at least n limbs. n is rounded up to the block's real
+//size. limbs_free takes either size back.
+limb_t * limbs_alloc(int & n);
+void limbs_free(limb_t *, const int);
+
+//Hand every block cached by the calling thread back to the heap,
+//for instance once a big computation is done with.
+void limbs_pool_release();
+
+//Standard allocator over the pool, for containers of limbs.
+template<class T>
+class LimbAllocator
+{
+public:
+    typedef T value_type;
+
+    LimbAllocator() = default;
+    template<class U>
+    LimbAllocator(const LimbAllocator<U> &)
+    {
+        return;
+    }
+
+    T * allocate(const std::size_t n)
+    {
+        static_assert(sizeof(T) == sizeof(limb_t), "limb sized types only");
+        int size = n;
+        return reinterpret_cast<T *>(limbs_alloc(size));
+    }
+
+    void deallocate(T * p, const std::size_t n)
+    {
+        limbs_free(reinterpret_cast<limb_t *>(p), n);
+        return;
+    }
+
+    template<class U>
+    bool operator==(const LimbAllocator<U> &) const { return true; }
+    template<class U>
+    bool operator!=(const LimbAllocator<U> &) const { return false; }
+};
+
+//std::vector<limb_t> drawing from the pool, for scratch space.
+typedef std::vector<limb_t, LimbAllocator<limb_t> > LimbVector;
+
+#endif
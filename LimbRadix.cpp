@@ -0,0 +1,328 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbRadix.cpp
+
+/*
+  Decimal and hexadecimal text for limb arrays.
+
+  Hexadecimal is a straight regrouping of bits. Decimal is divide
+  and conquer around the powers 10^(9 * 2^k): a number is split in
+  half by dividing by one of them and each half converted on its
+  own, and text is put back together by multiplying the high half
+  by one. Both ride on limbs_mul / limbs_divrem, so they are as fast
+  as those are instead of quadratic.
+*/
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+#include "LongIntStats.h"
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    typedef LimbVector Limbs;
+
+    //Largest power of ten that fits in a limb.
+    const limb_t DEC_CHUNK = 1000000000;
+    const int DEC_CHUNK_DIGITS = 9;
+
+    //10^(9 * 2^k), built once and shared. The table only grows,
+    //so references handed out stay good. Built powers are
+    //published one by one, so looking one up takes no lock; the
+    //lock is only taken to build the ones still missing.
+    const int DEC_POWERS_MAX = 32;
+
+    const Limbs & dec_power(const int k)
+    {
+        static std::atomic<const Limbs *> published[DEC_POWERS_MAX];
+
+        const Limbs * ret = published[k].load(std::memory_order_acquire);
+        if (ret != nullptr)
+            return *ret;
+
+        static std::mutex lock;
+        static std::vector<std::unique_ptr<Limbs> > powers;
+
+        std::lock_guard<std::mutex> guard(lock);
+        while (static_cast<int>(powers.size()) <= k)
+        {
+            Limbs * p = new Limbs;
+            if (powers.empty())
+                p->push_back(DEC_CHUNK);
+            else
+            {
+                const Limbs & last = *powers.back();
+                p->resize(2 * last.size());
+                limbs_mul(p->data(), last.data(), last.size(),
+                          last.data(), last.size());
+                p->resize(limbs_normalize(p->data(), p->size()));
+            }
+            powers.push_back(std::unique_ptr<Limbs>(p));
+            published[powers.size() - 1].store(p, std::memory_order_release);
+        }
+
+        return *powers[k];
+    }
+
+
+    //Write exactly width digits of x, zero padded on the left, by
+    //peeling nine digits at a time off the bottom.
+    void to_dec_basecase(char * out, const limb_t * x, int n, const int width)
+    {
+        Limbs t(x, x + n);
+        int pos = width;
+
+        while (n > 0 && pos > 0)
+        {
+            limb_t chunk = limbs_divrem_1(t.data(), t.data(), n, DEC_CHUNK);
+            n = limbs_normalize(t.data(), n);
+
+            for (int j = 0; j < DEC_CHUNK_DIGITS && pos > 0; j++)
+            {
+                out[--pos] = static_cast<char>('0' + chunk % 10);
+                chunk /= 10;
+            }
+        }
+
+        std::fill(out, out + pos, '0');
+
+        return;
+    }
+
+
+    //Write exactly 9 * 2^k digits of x, which must be less than
+    //10^(9 * 2^k).
+    void to_dec_rec(char * out, const limb_t * x, int n, const int k)
+    {
+        const int width = DEC_CHUNK_DIGITS << k;
+        n = limbs_normalize(x, n);
+
+        if (n < limb_thresholds.radix_dc || k == 0)
+        {
+            StatTimer timer(TIER_RADIX_BASECASE);
+            to_dec_basecase(out, x, n, width);
+            return;
+        }
+
+        //x = hi * 10^(width / 2) + lo.
+        const Limbs & p = dec_power(k - 1);
+        const int pn = p.size();
+        if (limbs_cmp(x, n, p.data(), pn) < 0)
+        {
+            std::fill(out, out + width / 2, '0');
+            to_dec_rec(out + width / 2, x, n, k - 1);
+            return;
+        }
+
+        Limbs hi(n - pn + 1), lo(pn);
+        limbs_divrem(hi.data(), lo.data(), x, n, p.data(), pn);
+        to_dec_rec(out, hi.data(), hi.size(), k - 1);
+        to_dec_rec(out + width / 2, lo.data(), lo.size(), k - 1);
+
+        return;
+    }
+
+
+    //r = the value of len decimal digits, returns its length.
+    int from_dec_basecase(limb_t * r, const char * s, const int len)
+    {
+        int n = 0;
+
+        //Take the odd sized chunk first so every chunk after it is
+        //exactly nine digits: r = r * 10^9 + chunk.
+        int chunk_len = len % DEC_CHUNK_DIGITS;
+        if (chunk_len == 0)
+            chunk_len = DEC_CHUNK_DIGITS;
+
+        for (int pos = 0; pos < len;
+             pos += chunk_len, chunk_len = DEC_CHUNK_DIGITS)
+        {
+            limb_t chunk = 0, scale = 1;
+            for (int j = 0; j < chunk_len; j++)
+            {
+                chunk = chunk * 10 + static_cast<limb_t>(s[pos + j] - '0');
+                scale *= 10;
+            }
+
+            limb_t carry = limbs_mul_1(r, r, n, scale);
+            if (carry != 0)
+                r[n++] = carry;
+
+            carry = limbs_add_1(r, r, n, chunk);
+            if (carry != 0)
+                r[n++] = carry;
+        }
+
+        return n;
+    }
+
+
+    int from_dec_rec(limb_t * r, const char * s, const int len)
+    {
+        if (len <= limb_thresholds.radix_dc * DEC_CHUNK_DIGITS)
+        {
+            StatTimer timer(TIER_RADIX_BASECASE);
+            return from_dec_basecase(r, s, len);
+        }
+
+        //Split off the largest 9 * 2^k low digits that leave
+        //something on top: value = hi * 10^width + lo.
+        int k = 0;
+        while ((DEC_CHUNK_DIGITS << (k + 1)) < len)
+            k++;
+        const int width = DEC_CHUNK_DIGITS << k;
+
+        Limbs hi(limbs_dec_limbs(len - width)), lo(limbs_dec_limbs(width));
+        int hn = from_dec_rec(hi.data(), s, len - width);
+        int ln = from_dec_rec(lo.data(), s + len - width, width);
+
+        const Limbs & p = dec_power(k);
+        const int pn = p.size();
+        if (hn == 0)
+        {
+            std::copy(lo.begin(), lo.begin() + ln, r);
+            return ln;
+        }
+
+        int n = hn + pn;
+        if (hn >= pn)
+            limbs_mul(r, hi.data(), hn, p.data(), pn);
+        else
+            limbs_mul(r, p.data(), pn, hi.data(), hn);
+
+        if (ln > 0)
+            limbs_add(r, r, n, lo.data(), ln);
+
+        return limbs_normalize(r, n);
+    }
+
+
+    int hex_value(const char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+
+        return -1;
+    }
+}
+
+
+int limbs_dec_size(const int n)
+{
+    //log10(2^32) is a little under 9.64.
+    return n * 9 + (n * 64 + 99) / 100 + 1;
+}
+
+
+int limbs_dec_limbs(const int len)
+{
+    //A limb holds at least nine digits. The extra limb covers
+    //from_dec_rec's hi * 10^width product, which can be one
+    //limb longer than its value.
+    return len / DEC_CHUNK_DIGITS + 2;
+}
+
+
+int limbs_to_dec(char * out, const limb_t * a, int n)
+{
+    n = limbs_normalize(a, n);
+    if (n == 0)
+    {
+        out[0] = '0';
+        return 1;
+    }
+
+    //Convert into a power of two number of nine digit chunks,
+    //then slide the real digits down over the padding.
+    int k = 0;
+    while ((DEC_CHUNK_DIGITS << k) < limbs_dec_size(n))
+        k++;
+
+    std::vector<char> buf(DEC_CHUNK_DIGITS << k);
+    {
+        StatTimer timer(TIER_RADIX_DC);
+        to_dec_rec(buf.data(), a, n, k);
+    }
+
+    int start = 0;
+    while (buf[start] == '0')
+        start++;
+
+    std::copy(buf.begin() + start, buf.end(), out);
+
+    return buf.size() - start;
+}
+
+
+int limbs_from_dec(limb_t * r, const char * s, const int len)
+{
+    //Leading zeros would only make the recursion deeper.
+    int start = 0;
+    while (start < len && s[start] == '0')
+        start++;
+
+    StatTimer timer(TIER_RADIX_DC);
+
+    return from_dec_rec(r, s + start, len - start);
+}
+
+
+int limbs_hex_size(const int n)
+{
+    return (n == 0 ? 1 : n * 8);
+}
+
+
+int limbs_hex_limbs(const int len)
+{
+    return (len + 7) / 8;
+}
+
+
+int limbs_to_hex(char * out, const limb_t * a, int n)
+{
+    static const char DIGITS[] = "0123456789abcdef";
+
+    n = limbs_normalize(a, n);
+    if (n == 0)
+    {
+        out[0] = '0';
+        return 1;
+    }
+
+    //Skip the top limb's leading zero nibbles.
+    int len = 0, shift = LIMB_BITS - 4;
+    while ((a[n - 1] >> shift) == 0)
+        shift -= 4;
+
+    for (int i = n - 1; i >= 0; i--, shift = LIMB_BITS - 4)
+        for (; shift >= 0; shift -= 4)
+            out[len++] = DIGITS[(a[i] >> shift) & 0xF];
+
+    return len;
+}
+
+
+int limbs_from_hex(limb_t * r, const char * s, const int len)
+{
+    const int n = limbs_hex_limbs(len);
+    std::fill(r, r + n, 0);
+
+    //Eight digits to a limb, counting from the right.
+    for (int i = 0; i < len; i++)
+    {
+        int pos = len - 1 - i;
+        r[i / 8] |= static_cast<limb_t>(hex_value(s[pos])) << (4 * (i % 8));
+    }
+
+    return limbs_normalize(r, n);
+}
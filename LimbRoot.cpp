@@ -0,0 +1,235 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbRoot.cpp
+
+/*
+  Integer k-th roots of limb arrays.
+
+  Newton's iteration x' = ((k - 1) x + a / x^(k-1)) / k, rounded
+  down, only decreases while x is above the root and stops at it, so
+  all it needs is a start at or above the root. A start good to h
+  bits is good to about 2h bits after one step, and the start comes
+  from the root of the top half of a, found the same way. The last
+  level is the native root of the top 64 bits. Each level costs a
+  few multiplications and divisions of its own length, so the whole
+  root costs about as much as the last level.
+*/
+
+#include "LimbOps.h"
+#include "LimbPool.h"
+#include "LongIntStats.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    typedef LimbVector Limbs;
+
+    inline
+    void trim(Limbs & x)
+    {
+        x.resize(limbs_normalize(x.data(), x.size()));
+        return;
+    }
+
+    inline
+    int cmp(const Limbs & x, const Limbs & y)
+    {
+        return limbs_cmp(x.data(), x.size(), y.data(), y.size());
+    }
+
+    int bit_length(const Limbs & x)
+    {
+        if (x.empty())
+            return 0;
+
+        int bits = (x.size() - 1) * LIMB_BITS;
+        for (limb_t top = x.back(); top != 0; top >>= 1)
+            bits++;
+
+        return bits;
+    }
+
+    //x >> p.
+    Limbs shift_down(const Limbs & x, const int p)
+    {
+        const int w = p / LIMB_BITS;
+        const unsigned s = p % LIMB_BITS;
+        if (w >= static_cast<int>(x.size()))
+            return Limbs();
+
+        Limbs r(x.begin() + w, x.end());
+        if (s != 0)
+            limbs_rshift(r.data(), r.data(), r.size(), s);
+        trim(r);
+
+        return r;
+    }
+
+    //x << p.
+    Limbs shift_up(const Limbs & x, const int p)
+    {
+        const int w = p / LIMB_BITS;
+        const unsigned s = p % LIMB_BITS;
+
+        Limbs r(w + x.size() + 1);
+        std::copy(x.begin(), x.end(), r.begin() + w);
+        if (s != 0)
+            r.back() = limbs_lshift(r.data() + w, r.data() + w, x.size(), s);
+        trim(r);
+
+        return r;
+    }
+
+    Limbs mul(const Limbs & x, const Limbs & y)
+    {
+        if (x.empty() || y.empty())
+            return Limbs();
+
+        const Limbs & big = (x.size() >= y.size() ? x : y);
+        const Limbs & small = (x.size() >= y.size() ? y : x);
+
+        Limbs r(big.size() + small.size());
+        limbs_mul(r.data(), big.data(), big.size(),
+                  small.data(), small.size());
+        trim(r);
+
+        return r;
+    }
+
+    //x^e for e >= 1, left to right.
+    Limbs power(const Limbs & x, const int e)
+    {
+        int top = 0;
+        while ((e >> top) > 1)
+            top++;
+
+        Limbs r(x);
+        for (int i = top - 1; i >= 0; i--)
+        {
+            r = mul(r, r);
+            if ((e >> i) & 1)
+                r = mul(r, x);
+        }
+
+        return r;
+    }
+
+    //x / y, y non zero.
+    Limbs divide(const Limbs & x, const Limbs & y)
+    {
+        if (cmp(x, y) < 0)
+            return Limbs();
+
+        Limbs q(x.size() - y.size() + 1), r(y.size());
+        limbs_divrem(q.data(), r.data(), x.data(), x.size(),
+                     y.data(), y.size());
+        trim(q);
+
+        return q;
+    }
+
+    //r^k <= x, without overflowing.
+    bool power_at_most(const dlimb_t r, const int k, const dlimb_t x)
+    {
+        dlimb_t p = 1;
+        for (int i = 0; i < k; i++)
+        {
+            if (r != 0 && p > x / r)
+                return false;
+            p *= r;
+        }
+
+        return true;
+    }
+
+    //Root of a native value, from the floating point estimate.
+    dlimb_t root_native(const dlimb_t x, const int k)
+    {
+        dlimb_t r = static_cast<dlimb_t>(
+            std::pow(static_cast<double>(x), 1.0 / k));
+
+        while (r > 0 && !power_at_most(r, k, x))
+            r--;
+        while (power_at_most(r + 1, k, x))
+            r++;
+
+        return r;
+    }
+
+    //floor(a^(1/k)) for a > 0 and k >= 2.
+    Limbs root(const Limbs & a, const int k)
+    {
+        const int bits = bit_length(a);
+
+        if (bits <= 2 * LIMB_BITS)
+        {
+            dlimb_t x = a[0];
+            if (a.size() > 1)
+                x |= static_cast<dlimb_t>(a[1]) << LIMB_BITS;
+
+            dlimb_t r = root_native(x, k);
+            Limbs ret(2);
+            ret[0] = static_cast<limb_t>(r);
+            ret[1] = static_cast<limb_t>(r >> LIMB_BITS);
+            trim(ret);
+
+            return ret;
+        }
+
+        //a < 2^bits <= 2^k.
+        if (k >= bits)
+            return Limbs(1, 1);
+
+        //Start from the root of the top half, rounded up so it is
+        //not below the root of a. Too few bits to split leaves
+        //2^ceil(bits / k), which is also above it.
+        const int h = bits / (2 * k);
+        Limbs x;
+        if (h == 0)
+            x = shift_up(Limbs(1, 1), (bits + k - 1) / k);
+        else
+        {
+            x = root(shift_down(a, k * h), k);
+            x.push_back(0);
+            limbs_add_1(x.data(), x.data(), x.size(), 1);
+            trim(x);
+            x = shift_up(x, h);
+        }
+
+        for (;;)
+        {
+            Limbs y = divide(a, (k == 2 ? x : power(x, k - 1)));
+
+            Limbs t(x.size() + 1);
+            t.back() = limbs_mul_1(t.data(), x.data(), x.size(), k - 1);
+            if (y.size() > t.size())
+                y.swap(t);
+            t.push_back(limbs_add(t.data(), t.data(), t.size(),
+                                  y.data(), y.size()));
+            limbs_divrem_1(t.data(), t.data(), t.size(), k);
+            trim(t);
+
+            if (cmp(t, x) >= 0)
+                break;
+            x.swap(t);
+        }
+
+        return x;
+    }
+}
+
+
+int limbs_root(limb_t * r, const limb_t * a, const int an, const int k)
+{
+    StatTimer timer(TIER_ROOT);
+    Limbs x(a, a + an);
+    if (k > 1)
+        x = root(x, k);
+
+    std::copy(x.begin(), x.end(), r);
+
+    return x.size();
+}
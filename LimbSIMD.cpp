@@ -0,0 +1,237 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbSIMD.cpp
+
+/*
+  Vector versions of limbs_add_n and limbs_sub_n for x86 processors
+  with AVX2 or AVX-512, picked at run time.
+
+  A vector of w limbs is added lane by lane, and the carries are then
+  sorted out all at once by carry lookahead on two w bit masks: g, the
+  lanes that overflowed, and p, the lanes that came out all ones and
+  so pass an incoming carry straight on. The lanes that take a carry
+  are
+      m = (((g << 1) | carry_in) + p) ^ p
+  since adding p ripples each carry through a run of all ones lanes,
+  and the carry out is bit w of the same sum. The only serial work is
+  that one scalar addition per vector. Subtraction is the same with
+  borrows: g is the lanes where a < b and p the lanes that came out
+  zero.
+
+  Define LIMBS_NO_SIMD to build without any of this.
+*/
+
+#include "LimbOps.h"
+
+#include <atomic>
+
+#if !defined(LIMBS_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LIMBS_SIMD
+#endif
+
+#ifdef LIMBS_SIMD
+namespace
+{
+    typedef int (*SimdFn)(limb_t *, const limb_t *, const limb_t *,
+                          const int, limb_t &);
+
+    __attribute__((target("avx2")))
+    int add_avx2(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n, limb_t & carry)
+    {
+        const __m256i ones = _mm256_set1_epi32(-1);
+        const __m256i lane = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        unsigned c = carry;
+
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i s = _mm256_add_epi32(x, y);
+
+            //No unsigned compare in AVX2: s >= x exactly when
+            //max(s, x) is s.
+            __m256i no_carry = _mm256_cmpeq_epi32(_mm256_max_epu32(s, x), s);
+            unsigned g = ~_mm256_movemask_ps(_mm256_castsi256_ps(no_carry)) & 0xFF;
+            unsigned p = _mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_cmpeq_epi32(s, ones)));
+
+            unsigned t = ((g << 1) | c) + p;
+            unsigned m = (t ^ p) & 0xFF;
+            c = t >> 8;
+
+            //Lanes in m are -1 in inc, subtracting adds the carry.
+            __m256i bit = _mm256_and_si256(_mm256_set1_epi32(m), lane);
+            __m256i inc = _mm256_cmpeq_epi32(bit, lane);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i),
+                                _mm256_sub_epi32(s, inc));
+        }
+
+        carry = c;
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    int sub_avx2(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n, limb_t & borrow)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i lane = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        unsigned c = borrow;
+
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i d = _mm256_sub_epi32(x, y);
+
+            //x >= y exactly when max(x, y) is x.
+            __m256i no_borrow = _mm256_cmpeq_epi32(_mm256_max_epu32(x, y), x);
+            unsigned g = ~_mm256_movemask_ps(_mm256_castsi256_ps(no_borrow)) & 0xFF;
+            unsigned p = _mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_cmpeq_epi32(d, zero)));
+
+            unsigned t = ((g << 1) | c) + p;
+            unsigned m = (t ^ p) & 0xFF;
+            c = t >> 8;
+
+            __m256i bit = _mm256_and_si256(_mm256_set1_epi32(m), lane);
+            __m256i dec = _mm256_cmpeq_epi32(bit, lane);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i),
+                                _mm256_add_epi32(d, dec));
+        }
+
+        borrow = c;
+        return i;
+    }
+
+    //AVX-512 has unsigned compares into mask registers and masked
+    //adds, so the masks never leave them.
+    __attribute__((target("avx512f")))
+    int add_avx512(limb_t * r, const limb_t * a, const limb_t * b,
+                   const int n, limb_t & carry)
+    {
+        const __m512i ones = _mm512_set1_epi32(-1);
+        unsigned c = carry;
+
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i s = _mm512_add_epi32(x, y);
+
+            unsigned g = _mm512_cmplt_epu32_mask(s, x);
+            unsigned p = _mm512_cmpeq_epi32_mask(s, ones);
+            unsigned t = ((g << 1) | c) + p;
+            __mmask16 m = static_cast<__mmask16>(t ^ p);
+            c = t >> 16;
+
+            _mm512_storeu_si512(r + i, _mm512_mask_sub_epi32(s, m, s, ones));
+        }
+
+        carry = c;
+        return i;
+    }
+
+    __attribute__((target("avx512f")))
+    int sub_avx512(limb_t * r, const limb_t * a, const limb_t * b,
+                   const int n, limb_t & borrow)
+    {
+        const __m512i ones = _mm512_set1_epi32(-1);
+        const __m512i zero = _mm512_setzero_si512();
+        unsigned c = borrow;
+
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i d = _mm512_sub_epi32(x, y);
+
+            unsigned g = _mm512_cmplt_epu32_mask(x, y);
+            unsigned p = _mm512_cmpeq_epi32_mask(d, zero);
+            unsigned t = ((g << 1) | c) + p;
+            __mmask16 m = static_cast<__mmask16>(t ^ p);
+            c = t >> 16;
+
+            _mm512_storeu_si512(r + i, _mm512_mask_add_epi32(d, m, d, ones));
+        }
+
+        borrow = c;
+        return i;
+    }
+
+    int none(limb_t *, const limb_t *, const limb_t *, const int, limb_t &)
+    {
+        return 0;
+    }
+
+
+    //Each entry starts out as a function that looks at the
+    //processor, replaces the entry with the best kernel and calls
+    //it. Constant initialized, so it works during static
+    //initialization too.
+    int pick_add(limb_t *, const limb_t *, const limb_t *, const int,
+                 limb_t &);
+    int pick_sub(limb_t *, const limb_t *, const limb_t *, const int,
+                 limb_t &);
+
+    std::atomic<SimdFn> add_impl(pick_add);
+    std::atomic<SimdFn> sub_impl(pick_sub);
+
+    int pick_add(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n, limb_t & carry)
+    {
+        __builtin_cpu_init();
+        SimdFn f = none;
+        if (__builtin_cpu_supports("avx512f"))
+            f = add_avx512;
+        else if (__builtin_cpu_supports("avx2"))
+            f = add_avx2;
+
+        add_impl.store(f, std::memory_order_relaxed);
+        return f(r, a, b, n, carry);
+    }
+
+    int pick_sub(limb_t * r, const limb_t * a, const limb_t * b,
+                 const int n, limb_t & borrow)
+    {
+        __builtin_cpu_init();
+        SimdFn f = none;
+        if (__builtin_cpu_supports("avx512f"))
+            f = sub_avx512;
+        else if (__builtin_cpu_supports("avx2"))
+            f = sub_avx2;
+
+        sub_impl.store(f, std::memory_order_relaxed);
+        return f(r, a, b, n, borrow);
+    }
+}
+#endif
+
+
+int limbs_add_n_simd(limb_t * r, const limb_t * a, const limb_t * b,
+                     const int n, limb_t & carry)
+{
+#ifdef LIMBS_SIMD
+    return add_impl.load(std::memory_order_relaxed)(r, a, b, n, carry);
+#else
+    return 0;
+#endif
+}
+
+
+int limbs_sub_n_simd(limb_t * r, const limb_t * a, const limb_t * b,
+                     const int n, limb_t & borrow)
+{
+#ifdef LIMBS_SIMD
+    return sub_impl.load(std::memory_order_relaxed)(r, a, b, n, borrow);
+#else
+    return 0;
+#endif
+}
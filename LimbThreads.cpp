@@ -0,0 +1,192 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbThreads.cpp
+
+#include "LimbOps.h"
+#include "LimbThreads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    //Tasks handed out by one limbs_parallel call.
+    struct Batch
+    {
+        std::atomic<int> left;
+        std::exception_ptr error;
+    };
+
+    struct Task
+    {
+        std::function<void()> * f;
+        Batch * batch;
+    };
+
+
+    /*
+      One shared deque of tasks. New batches go on the back and
+      every thread takes from the back, so the most recently split,
+      smallest pieces run first and a waiting thread usually picks
+      up its own tasks. Tasks here are whole multiplications of at
+      least limb_thresholds.parallel limbs, so one lock is not
+      contended enough to need a deque per thread.
+    */
+    class Pool
+    {
+    public:
+        Pool() :
+            threads_(1),
+            stop_(false)
+        {
+            return;
+        }
+
+        ~Pool()
+        {
+            resize(1);
+            return;
+        }
+
+        int threads() const { return threads_; }
+
+        //Start or stop workers so there are threads - 1 of them.
+        void resize(const int threads)
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (std::thread & t : workers_)
+                t.join();
+            workers_.clear();
+
+            stop_ = false;
+            threads_ = std::max(threads, 1);
+            for (int i = 1; i < threads_; i++)
+                workers_.emplace_back(&Pool::work, this);
+
+            return;
+        }
+
+        void run(std::vector<std::function<void()> > & tasks)
+        {
+            Batch batch;
+            batch.left = tasks.size();
+
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                for (std::function<void()> & f : tasks)
+                    queue_.push_back(Task{ &f, &batch });
+            }
+            wake_.notify_all();
+
+            std::unique_lock<std::mutex> guard(lock_);
+            while (batch.left != 0)
+            {
+                if (!queue_.empty())
+                    run_one(guard);
+                else
+                    wake_.wait(guard);
+            }
+
+            if (batch.error)
+                std::rethrow_exception(batch.error);
+
+            return;
+        }
+
+    private:
+        int threads_;
+        bool stop_;
+        std::mutex lock_;
+        std::condition_variable wake_;
+        std::deque<Task> queue_;
+        std::vector<std::thread> workers_;
+
+        void work()
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            while (!stop_)
+            {
+                if (!queue_.empty())
+                    run_one(guard);
+                else
+                    wake_.wait(guard);
+            }
+
+            return;
+        }
+
+        //Take the newest task and run it without the lock held.
+        void run_one(std::unique_lock<std::mutex> & guard)
+        {
+            Task task = queue_.back();
+            queue_.pop_back();
+            guard.unlock();
+
+            try
+            {
+                (*task.f)();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> error_guard(lock_);
+                if (!task.batch->error)
+                    task.batch->error = std::current_exception();
+            }
+
+            guard.lock();
+            if (--task.batch->left == 0)
+                wake_.notify_all();
+
+            return;
+        }
+    };
+
+    Pool & pool()
+    {
+        static Pool p;
+        return p;
+    }
+}
+
+
+void limbs_set_threads(const int threads)
+{
+    pool().resize(threads);
+    return;
+}
+
+
+int limbs_threads()
+{
+    return pool().threads();
+}
+
+
+bool limbs_go_parallel(const int n)
+{
+    return n >= limb_thresholds.parallel && pool().threads() > 1;
+}
+
+
+void limbs_parallel(std::vector<std::function<void()> > & tasks)
+{
+    if (pool().threads() <= 1)
+    {
+        for (std::function<void()> & f : tasks)
+            f();
+    }
+
+    else
+        pool().run(tasks);
+
+    return;
+}
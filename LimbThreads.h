@@ -0,0 +1,50 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LimbThreads.h
+
+/*
+  The thread pool behind parallel multiplication. Only the limb
+  routines use this directly; the knob for users is
+  limbs_set_threads in LimbOps.h.
+
+  limbs_parallel is fork and join: it hands out a batch of tasks and
+  returns when all of them are done. A thread waiting on its batch
+  runs queued tasks, its own or anyone else's, instead of sleeping,
+  so tasks can start batches of their own without tying up the
+  pool.
+*/
+
+#ifndef LIMB_THREADS_H
+#define LIMB_THREADS_H
+
+#include <functional>
+#include <vector>
+
+//Whether work on operands of n limbs should be split across
+//threads: more than one thread is allowed and n has reached
+//limb_thresholds.parallel.
+bool limbs_go_parallel(const int);
+
+//Run every task and return once all of them have finished. The
+//calling thread runs tasks too. The first exception thrown by a
+//task is rethrown here after the rest have finished.
+void limbs_parallel(std::vector<std::function<void()> > &);
+
+//Call each of f, through limbs_parallel if parallel is set and one
+//after the other on this thread if not.
+template<class... F>
+void limbs_invoke(const bool parallel, F &&... f)
+{
+    if (parallel)
+    {
+        std::vector<std::function<void()> > tasks = { f... };
+        limbs_parallel(tasks);
+    }
+
+    else
+        (f(), ...);
+
+    return;
+}
+
+#endif
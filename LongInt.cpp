@@ -3,155 +3,505 @@
 //File: LongInt.cpp
 
 #include "LongInt.h"
+#include "LongIntStats.h"
 
-LongInt::LongInt() : sign_(1)
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
+
+namespace
 {
-    x_.resize(1);
-    x_[0] = 0;
-    
-    return;
-}
+    //Largest power of ten that fits in a limb. Decimal text is
+    //converted nine digits at a time.
+    const limb_t DEC_CHUNK = 1000000000;
+    const int DEC_CHUNK_DIGITS = 9;
+
+    //Magnitudes that fit in a native integer skip the limb
+    //routines entirely.
+#if defined(__SIZEOF_INT128__)
+    typedef unsigned __int128 small_t;
+#else
+    typedef dlimb_t small_t;
+#endif
+
+    const int SMALL_LIMBS = sizeof(small_t) / sizeof(limb_t);
+    const int SMALL64_LIMBS = sizeof(std::uint64_t) / sizeof(limb_t);
+
+    //The digit cache converts the first and last DIGIT_CHUNK
+    //digits of a big value on their own. Anything in between, and
+    //values of up to two chunks, convert everything.
+    const int DIGIT_CHUNK = 256 * DEC_CHUNK_DIGITS;
+
+    //Odd multiplier taking the cached 32-bit hash to a full word.
+    const std::uint64_t HASH_SPREAD = 0x9E3779B97F4A7C15ULL;
+
+    //Seed for LongInt::hash(), the same for the whole process.
+    std::uint64_t hash_seed()
+    {
+#ifdef LONGINT_HASH_SEED
+        static const std::uint64_t seed = LONGINT_HASH_SEED;
+#else
+        static const std::uint64_t seed = []()
+        {
+            std::random_device rd;
+            return static_cast<std::uint64_t>(rd()) << 32 | rd();
+        }();
+#endif
 
+        return seed;
+    }
 
-LongInt::LongInt(const char s[])
-{
-    //start_zeros records the number of zeros at the beginning of
-    //the string before another number. num_start determines when
-    //the number has started so we can start recording zeros.
-    //This means that "00000000" still becomes just 0.
-    //Thhis also means that "000024" becomes 24.
-    int i = 0, start_zeros = 0;
-    bool num_start = false;
-    
-    //Positive / zero
-    if (s[0] != '-')
+    small_t load_small(const LimbArr & x)
     {
-        //Set sign
-        sign_ = 1;
+        small_t ret = 0;
+        for (int i = x.size() - 1; i >= 0; i--)
+            ret = (ret << LIMB_BITS) | x[i];
 
-        //Set size.
-        while (s[i] != '\0')
-        {
-            if (!num_start && s[i] == '0')
-                start_zeros++;
-            else if (!num_start)
-                num_start = true;
+        return ret;
+    }
 
-            i++;
+    void store_small(LimbArr & x, small_t v)
+    {
+        x.clear();
+        while (v != 0)
+        {
+            x.push_back(static_cast<limb_t>(v));
+            v >>= LIMB_BITS;
         }
-        
-        x_.resize(i - start_zeros);
-        
-        if (x_.size() == 0 && s[i - 1] == '0')
+
+        return;
+    }
+
+    //x with the given sign in two's complement, in the r.size()
+    //limbs of r. r has to be longer than x to hold the sign bit.
+    void load_twos(LimbArr & r, const LimbArr & x, const int sign)
+    {
+        std::fill(r.data(), r.data() + r.size(), 0);
+        std::copy(x.data(), x.data() + x.size(), r.data());
+        if (sign == -1)
         {
-            x_.resize(1);
-            start_zeros--;
+            limbs_com(r.data(), r.data(), r.size());
+            limbs_add_1(r.data(), r.data(), r.size(), 1);
         }
-        
-        //Set digits.
-        for (i = 0; i < x_.size(); i++)
+
+        return;
+    }
+
+    //Back from two's complement to a magnitude, returns the sign.
+    int store_twos(LimbArr & r)
+    {
+        if (r.empty() || !(r.back() >> (LIMB_BITS - 1)))
+            return 1;
+
+        limbs_com(r.data(), r.data(), r.size());
+        limbs_add_1(r.data(), r.data(), r.size(), 1);
+
+        return -1;
+    }
+
+    //Whether r is a square mod m.
+    bool is_square_mod(const limb_t r, const limb_t m)
+    {
+        for (limb_t i = 0; i <= m / 2; i++)
         {
-            //Set digit using ascii character of
-            //the digit in the string.
-            x_[(x_.size() - 1) - i] =
-                static_cast<int>(s[i + start_zeros]) - 48;
+            if (i * i % m == r)
+                return true;
         }
+
+        return false;
     }
 
-    //Negative
-    else
+    //Primes that screen k-th powers for odd k. When k divides
+    //p - 1, only one in k of the units mod p is a k-th power, so
+    //each of these throws out most non powers for every such k.
+    const limb_t SCREEN_PRIMES[] =
     {
-        //Set sign
-        sign_ = -1;
+        7, 11, 13, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71,
+        73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137, 139,
+        149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211,
+        223, 227, 229, 233, 239, 241, 251
+    };
+
+    const int SCREEN_COUNT = sizeof(SCREEN_PRIMES) / sizeof(SCREEN_PRIMES[0]);
 
-        //Set Size
-        while (s[i] != '\0')
+    //b^e mod m.
+    limb_t pow_mod_limb(limb_t b, limb_t e, const limb_t m)
+    {
+        limb_t ret = 1;
+        while (e != 0)
         {
-            if (!num_start && s[i] == '0')
-                start_zeros++;
-            else if (!num_start)
-                num_start = true;
+            if (e & 1)
+                ret = static_cast<dlimb_t>(ret) * b % m;
+            b = static_cast<dlimb_t>(b) * b % m;
+            e >>= 1;
+        }
 
-            i++;
+        return ret;
+    }
+
+    bool is_prime_limb(const limb_t p)
+    {
+        for (limb_t d = 2; static_cast<dlimb_t>(d) * d <= p; d++)
+        {
+            if (p % d == 0)
+                return false;
         }
-        
-        x_.resize(i - start_zeros - 1);
-        
-        if (x_.size() == 0 && s[i - 1] == '0')
+
+        return p >= 2;
+    }
+
+    //m mod each of count primes, as many primes to a pass over m as
+    //fit in a limb.
+    void screen_residues(const LongInt & m, const limb_t * primes,
+                         const int count, limb_t * res)
+    {
+        LimbArr q(m.limb_count());
+        int i = 0;
+        while (i < count)
         {
-            x_.resize(1);
-            start_zeros--;
+            dlimb_t d = 1;
+            int j = i;
+            while (j < count && (d * primes[j]) >> LIMB_BITS == 0)
+                d *= primes[j++];
+
+            const limb_t r = limbs_divrem_1(q.data(), m.limbs(),
+                                            m.limb_count(),
+                                            static_cast<limb_t>(d));
+            for (; i < j; i++)
+                res[i] = r % primes[i];
         }
-        
-        //Set digits
-        for (i = 0; i < x_.size(); i++)
+
+        return;
+    }
+
+    //Whether m, with those residues, can be a k-th power. tried
+    //gets the number of the primes that had a say.
+    bool passes_screen(const limb_t * primes, const int count,
+                       const limb_t * res, const int k, int & tried)
+    {
+        tried = 0;
+        for (int i = 0; i < count; i++)
         {
-            //Set digit using ascii character of
-            //the digit in the string.
-            x_[(x_.size() - 1) - i] =
-                static_cast<int>(s[i + start_zeros + 1]) - 48;
+            const limb_t p = primes[i];
+            if ((p - 1) % k != 0)
+                continue;
+
+            tried++;
+            if (res[i] != 0 && pow_mod_limb(res[i], (p - 1) / k, p) != 1)
+                return false;
         }
 
-        //If someone entered "-0", this makes sign positive.
-        if (x_.size() == 1 && x_[0] == 0)
+        return true;
+    }
+
+    //The same with the two smallest primes p = 1 mod 2k.
+    bool passes_own_screen(const LongInt & m, const int k)
+    {
+        limb_t primes[2], res[2];
+        int found = 0;
+        for (limb_t p = 2 * k + 1; found < 2; p += 2 * k)
         {
-            sign_ = 1;
+            if (is_prime_limb(p))
+                primes[found++] = p;
         }
+
+        int tried = 0;
+        screen_residues(m, primes, 2, res);
+
+        return passes_screen(primes, 2, res, k, tried);
     }
 
-    return;
-}
+    const int SMALL_BITS = SMALL_LIMBS * LIMB_BITS;
 
+    //1 / v mod 2^SMALL_BITS for odd v, by Newton's method. v is
+    //its own inverse mod 8, and each step doubles the correct bits.
+    small_t inverse_small(const small_t v)
+    {
+        small_t ret = v;
+        for (int bits = 3; bits < SMALL_BITS; bits *= 2)
+            ret *= 2 - v * ret;
 
-LongInt::LongInt(const int num)
-{
-    if (num == 0)
+        return ret;
+    }
+
+    //The k-th root of odd v mod 2^bits for odd k and bits up to
+    //SMALL_BITS, which always exists and is unique: v^(1 / k mod
+    //2^bits).
+    small_t root_small(small_t v, const int k, const int bits)
     {
-        sign_ = 1;
-        x_.resize(1);
-        x_[0] = 0;
+        small_t e = inverse_small(k), ret = 1;
+        if (bits < SMALL_BITS)
+            e &= (small_t(1) << bits) - 1;
+
+        while (e != 0)
+        {
+            if (e & 1)
+                ret *= v;
+            v *= v;
+            e >>= 1;
+        }
+
+        return ret;
     }
 
-    else
+    LongInt small_to_long(const small_t v)
     {
-        //Set sign.
-        if (num < 0)
-            sign_ = -1;
-        else
-            sign_ = 1;
+        LongInt ret;
+        for (int i = SMALL_LIMBS - 1; i >= 0; i--)
+        {
+            ret <<= LIMB_BITS;
+            ret |= static_cast<limb_t>(v >> (i * LIMB_BITS));
+        }
+
+        return ret;
+    }
 
-        //Set size.
-        int i = 0, t = num;
-        while (t != 0)
+    //x^k & mask, for a mask of the low bits.
+    LongInt pow_low(const LongInt & x, const int k, const LongInt & mask)
+    {
+        LongInt ret = 1;
+        for (int bit = 30; bit >= 0; bit--)
         {
-            t /= 10;
-            i++;
+            if (ret != 1)
+                ret = (ret * ret) & mask;
+            if ((k >> bit) & 1)
+                ret = (ret * x) & mask;
         }
-        
-        x_.resize(i);
-        //Set digits
-        for (i = 0; i < x_.size(); i++)
+
+        return ret;
+    }
+
+    //The only x < 2^e with x^k = m mod 2^e, for odd m and odd k,
+    //given r, that root mod 2^SMALL_BITS. y = 1 / x is lifted by
+    //    y += y (1 - m y^k) / k
+    //which doubles its correct bits each time, and then
+    //x = m y^(k - 1).
+    LongInt root_mod_2exp(const LongInt & m, const int k, const small_t r,
+                          const int e)
+    {
+        LongInt y = small_to_long(inverse_small(r));
+        LongInt k_inv = small_to_long(inverse_small(k));
+        int bits = SMALL_BITS;
+        while (bits < e)
         {
-            t = num;
-            for (int j = 0; j < (x_.size() - 1) - i; j++)
-                t /= 10;
-            if (sign_ == -1)
-                x_[(x_.size() - 1) - i] = (t % 10) * -1;
-            else
-                x_[(x_.size() - 1) - i] = t % 10;
+            bits = std::min(2 * bits, e);
+            const LongInt mask = (LongInt(1) << bits) - 1;
+
+            //& of a negative number takes it mod 2^bits as well.
+            k_inv = (k_inv * (2 - k * k_inv)) & mask;
+            const LongInt t = (1 - (m & mask) * pow_low(y, k, mask)) & mask;
+            y = (y + (((y * t) & mask) * k_inv)) & mask;
         }
+
+        const LongInt mask = (LongInt(1) << e) - 1;
+
+        return ((m & mask) * pow_low(y, k - 1, mask)) & mask;
     }
-    
+
+    //log2 of x / 2^(bit_length - 1), from the top limbs of x > 0.
+    double log2_mantissa(const LongInt & x)
+    {
+        const int n = x.limb_count(), top = std::min(n, 3);
+        double f = 0;
+        for (int i = n - 1; i >= n - top; i--)
+            f = f * 4294967296.0 + x.limbs()[i];
+
+        return std::log2(f) - (x.bit_length() - 1 - (n - top) * LIMB_BITS);
+    }
+
+    //x += y with signs, when both are short enough that the sum
+    //fits a small_t. Returns false if they are not.
+    bool small_add(LimbArr & x, int & x_sign, const LimbArr & y,
+                   const int y_sign)
+    {
+        if (x.size() >= SMALL_LIMBS || y.size() >= SMALL_LIMBS)
+            return false;
+
+        small_t a = load_small(x), b = load_small(y);
+        if (x_sign == y_sign)
+            a += b;
+        else if (a >= b)
+            a -= b;
+        else
+        {
+            a = b - a;
+            x_sign *= -1;
+        }
+
+        store_small(x, a);
+
+        return true;
+    }
+}
+
+
+//Digits of the magnitude, most significant first. Chunk k holds
+//the digits for 10^(k * DIGIT_CHUNK) and up, so the last chunk in
+//the string is chunk 0. A chunk's digits are only read once its
+//ready flag is set, and only written, under the lock, before that.
+struct LongInt::DigitCache
+{
+    int size;
+    std::string digits;
+    int chunks;
+    std::unique_ptr<std::atomic<bool>[]> ready;
+    std::mutex lock;
+};
+
+
+LongInt::LongInt() : sign_(1)
+{
+    return;
+}
+
+
+LongInt::LongInt(const char s[]) : sign_(1)
+{
+    int i = 0;
+
+    //Negative
+    if (s[0] == '-')
+    {
+        sign_ = -1;
+        i++;
+    }
+
+    int len = 0;
+    while (s[i + len] != '\0')
+        len++;
+
+    x_.resize(limbs_dec_limbs(len));
+    x_.resize(limbs_from_dec(x_.data(), s + i, len));
+    stats_op(STAT_PARSE, x_.size());
+
+    //If someone entered "-0", this makes sign positive.
+    trim();
+
+    return;
+}
+
+
+LongInt::LongInt(const int num) : sign_(num < 0 ? -1 : 1)
+{
+    //Negate as unsigned so INT_MIN works.
+    limb_t mag = static_cast<limb_t>(num);
+    if (num < 0)
+        mag = 0 - mag;
+
+    if (mag != 0)
+        x_.push_back(mag);
+
+    return;
+}
+
+
+LongInt::LongInt(const std::int64_t num) : sign_(1)
+{
+    assign_int64(num);
+    return;
+}
+
+
+LongInt::LongInt(const std::uint64_t num) : sign_(1)
+{
+    assign_uint64(num);
+    return;
+}
+
+
+LongInt::LongInt(const limb_t * x, const int n, const int sign) :
+    sign_(sign)
+{
+    x_.assign(x, x + n);
+    trim();
+
+    return;
+}
+
+
+LongInt::LongInt(const LongInt & l) :
+    x_(l.x_),
+    sign_(l.sign_),
+    hash_(l.hash_.load(std::memory_order_relaxed))
+{
+    stats_op(STAT_COPY, x_.size());
+    return;
+}
+
+
+LongInt::LongInt(LongInt && l) noexcept :
+    x_(std::move(l.x_)),
+    sign_(l.sign_)
+{
+    //l is left as zero. Its digits and hash go with its limbs.
+    l.sign_ = 1;
+    dec_.store(l.dec_.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+    l.dec_.store(nullptr, std::memory_order_relaxed);
+    hash_.store(l.hash_.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    l.hash_.store(0, std::memory_order_relaxed);
+
+    return;
+}
+
+
+LongInt::~LongInt()
+{
+    forget_caches();
     return;
 }
 
 
+int LongInt::size() const
+{
+    return digit_cache().size;
+}
+
+
+int LongInt::operator[](const int i) const
+{
+    DigitCache & c = digit_cache();
+    const int k = (c.size - 1 - i) / DIGIT_CHUNK;
+    if (!c.ready[k].load(std::memory_order_acquire))
+        fill_digits(c, k);
+
+    return c.digits[i] - '0';
+}
+
+
 const LongInt & LongInt::operator=(const LongInt & l)
 {
+    if (this != &l)
+        forget_caches();
     sign_ = l.sign();
-    x_.resize(l.size());
-    for (int i = 0; i < x_.size(); i++)
-        x_[i] = l[(l.size() - 1) - i];
+    x_ = l.x_;
+    hash_.store(l.hash_.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    stats_op(STAT_COPY, x_.size());
+
+    return *this;
+}
+
+
+const LongInt & LongInt::operator=(LongInt && l) noexcept
+{
+    if (this != &l)
+    {
+        forget_caches();
+        x_ = std::move(l.x_);
+        sign_ = l.sign_;
+        l.sign_ = 1;
+        dec_.store(l.dec_.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+        l.dec_.store(nullptr, std::memory_order_relaxed);
+        hash_.store(l.hash_.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        l.hash_.store(0, std::memory_order_relaxed);
+    }
 
     return *this;
 }
@@ -174,17 +524,7 @@ bool LongInt::operator==(const LongInt & l) const
     if (this == &l)
         return true;
     
-    if (sign_ != l.sign() ||
-        x_.size() != l.size())
-    {
-        return false;
-    }
-
-    for (int i = 0; i < x_.size(); i++)
-        if (x_[i] != l[(l.size() - 1) - i])
-            return false;
-    
-    return true;
+    return sign_ == l.sign() && x_ == l.x_;
 }
 
 
@@ -202,15 +542,10 @@ bool LongInt::operator>(const LongInt & l) const
     if (sign_ != l.sign())
         return (sign_ > l.sign() ? true : false);
 
-    if (x_.size() != l.size())
-        return (x_.size() > l.size() ? true : false);
-
-    for (int i = x_.size() - 1; i >= 0; i--)
-        if (x_[i] != l[(l.size() - 1) - i])
-            return (x_[i] > l[(l.size() - 1) - i] ? true : false);
-
-    //If equal.
-    return false;
+    //Same sign, so compare magnitudes. A bigger magnitude is
+    //the smaller number when both are negative.
+    return limbs_cmp(x_.data(), x_.size(), l.x_.data(), l.x_.size())
+        * sign_ > 0;
 }
 
 
@@ -234,57 +569,32 @@ bool LongInt::operator<=(const LongInt & l) const
 
 LongInt& LongInt::operator+=(const LongInt & l)
 {
-    if (sign_ != l.sign())
-    {
-        LongInt t = l;
-        t.sign() *= -1;
-        
-        return *this -= t;
-    }
+    stats_op(STAT_ADD, std::max(x_.size(), l.x_.size()));
+    return add_signed(l, l.sign());
+}
 
-    //Add zeros in unfilled spaces, if any.
-    if (l.size() > x_.size())
-    {
-        int og_size = x_.size();
-        for (int i = 0; i < l.size() - og_size; i++)
-            x_.push_back(0);
-    }
 
-    //Add values.
-    for (int i = 0; i < l.size(); i++)
-        x_[i] += l[(l.size() - 1) - i];
+LongInt LongInt::operator+(const LongInt & l) const &
+{
+    return LongInt(*this) += l;
+}
 
-    //Adjust values for overflow
-    for (int i = 0; i < x_.size(); i++)
-    {
-        if (x_[i] > 9)
-        {
-            if (i + 1 >= x_.size())
-            {
-                x_.push_back(0);
-            }
-            
-            x_[i + 1] += x_[i] / 10;
-            x_[i] %= 10;
-        }
-    }
 
-    //Remove redundant zeros.
-    for (int i = x_.size() - 1; i > 0; i--)
-    {
-        if (x_[i] == 0)
-            x_.pop_back();
-        else
-            break;
-    }
+LongInt LongInt::operator+(const LongInt & l) &&
+{
+    return std::move(*this += l);
+}
 
-    return *this;
+
+LongInt LongInt::operator+(LongInt && l) const &
+{
+    return std::move(l += *this);
 }
 
 
-LongInt LongInt::operator+(const LongInt & l) const
+LongInt LongInt::operator+(LongInt && l) &&
 {
-    return LongInt(*this) += l;
+    return std::move(*this += l);
 }
 
 
@@ -312,114 +622,20 @@ LongInt & LongInt::operator++()
 
 LongInt& LongInt::operator-=(const LongInt & l)
 {
-    if (sign_ != l.sign())
-    {
-        LongInt t = l;
-        t.sign() *= -1;
-        
-        return *this += t;
-    }
-
-    //Add zeros in unfilled spaces, if any.
-    if (l.size() > x_.size())
-    {
-        int og_size = x_.size();
-        for (int i = 0; i < l.size() - og_size; i++)
-            x_.push_back(0);
-    }
-
-    //Subtract values.
-    for (int i = 0; i < l.size(); i++)
-        x_[i] -= l[(l.size() - 1) - i];
-
-    //Adjust values for underflow
-    for (int i = 0, t; i < x_.size(); i++)
-    {
-        if (x_[i] < 0)
-        {
-            //Attempt to find next number.
-            for (t = i + 1; t < x_.size(); t++)
-            {
-                if (x_[t] > 0)
-                    break;
-            }
-
-            //If found.
-            if (t != x_.size() && x_[t] > 0)
-            {
-                for (int j = t; j >= 0; j--)
-                {
-                    if (j == t)
-                    {
-                        x_[j] -= 1;
-                        if (x_[j] == 0 && j == x_.size() - 1)
-                            x_.pop_back();
-                    }
-
-                    else if (j == 0)
-                        x_[j] += 10;
-                    else
-                        x_[j] += 9;
-                }
-
-                //Reset i.
-                i = -1;
-            }
-
-            //If not found.
-            else
-            {
-                //swap sign.
-                sign_ *= -1;
-                //Swap signs of all numbers.
-                for (int j = 0; j < x_.size(); j++)
-                    x_[j] *= -1;
-
-                //Reset i.
-                i = -1;
-            }
-        }
-    }
-    
-    //This loop will correct overflow.
-    for (int i = 0; i < x_.size(); i++)
-    {
-        if (x_[i] > 9)
-        {
-            if (i + 1 >= x_.size())
-            {
-                x_.push_back(0);
-            }
-            
-            x_[i + 1] += x_[i] / 10;
-            x_[i] %= 10;
-        }
-    }
-    
-    //Remove redundant zeros.
-    for (int i = x_.size() - 1; i >= 0; i--)
-    {
-        if (x_[i] == 0)
-            x_.pop_back();
-        else
-            break;
-    }
+    stats_op(STAT_SUB, std::max(x_.size(), l.x_.size()));
+    return add_signed(l, -l.sign());
+}
 
-    //If it is all just zeros in a row.
-    if (x_.empty())
-    {
-        x_.push_back(0);
-        if (sign_ == -1)
-            sign_ = 1;
-    }
 
-    return *this;
+LongInt LongInt::operator-(const LongInt & l) const &
+{
+    return LongInt(*this) -= l;
 }
 
 
-LongInt LongInt::operator-(const LongInt & l) const
+LongInt LongInt::operator-(const LongInt & l) &&
 {
-    return LongInt(*this) -= l;
+    return std::move(*this -= l);
 }
 
 
@@ -451,291 +667,1445 @@ LongInt & LongInt::operator--()
 
 LongInt & LongInt::operator*=(const LongInt & l)
 {
+    stats_op(STAT_MUL, std::max(x_.size(), l.x_.size()));
+
     if (l == 0)
         *this = 0;
 
     else if (*this != 0)
     {
-        LongInt sum = 0, term;
-
-        for (int i = 0; i < l.size(); i++)
-        {
-            term = this->abs();
-            term.multeq_digit(l[i]);
-            term.multeq_tenpower((l.size() - 1) - i);
-            sum += term;
+        if (sign_ != l.sign())
+            sign_ = -1;
+        else
+            sign_ = 1;
+
+        //Product fits a small_t.
+        if (x_.size() <= SMALL_LIMBS / 2 && l.x_.size() <= SMALL_LIMBS / 2)
+        {
+            store_small(x_, load_small(x_) * load_small(l.x_));
+            forget_caches();
+            return *this;
         }
 
-        if (sign_ != l.sign())
-            sum.sign() = -1;
-    
-        *this = sum;
+        const LimbArr & a = (x_.size() >= l.x_.size() ? x_ : l.x_);
+        const LimbArr & b = (x_.size() >= l.x_.size() ? l.x_ : x_);
+
+        LimbArr prod(a.size() + b.size());
+        limbs_mul(prod.data(), a.data(), a.size(), b.data(), b.size());
+
+        x_.swap(prod);
+        trim();
     }
     
     return *this;
 }
 
 
-LongInt LongInt::operator*(const LongInt & l) const
+LongInt LongInt::operator*(const LongInt & l) const &
 {
     return LongInt(*this) *= l;
 }
 
 
-LongInt & LongInt::operator/=(const LongInt & l)
+LongInt LongInt::operator*(const LongInt & l) &&
 {
-    if (l == 0)
-        throw DivideByZeroError();
+    return std::move(*this *= l);
+}
 
-    else if (abs() < l.abs())
-        *this = 0;
 
-    else
-    {
-        LongInt quotient = 0,
-            this_abs = abs(),
-            sub = l.abs(),
-            temp = 0;
+LongInt LongInt::operator*(LongInt && l) const &
+{
+    return std::move(l *= *this);
+}
 
-        for (int i = 0; i < x_.size(); i++)
-        {
-            temp += this_abs[i];
-            
-            while (temp - sub >= 0)
-            {
-                temp -= sub;
-                quotient++;
-            }
-            
-            if (i != x_.size() - 1)
-            {
-                quotient.multeq_tenpower(1);
-                temp.multeq_tenpower(1);
-            }
-        }    
 
-        if (sign_ != l.sign())
-        {
-            *this = quotient;
-            sign_ = -1;
-        }
+LongInt LongInt::operator*(LongInt && l) &&
+{
+    return std::move(*this *= l);
+}
 
-        else
-            *this = quotient;
-    }
+
+LongInt & LongInt::operator/=(const LongInt & l)
+{
+    stats_op(STAT_DIV, x_.size());
+    LongInt remainder;
+    divmod(l, *this, remainder);
 
     return *this;
 }
 
 
-LongInt LongInt::operator/(const LongInt & l) const
+LongInt LongInt::operator/(const LongInt & l) const &
 {
     return LongInt(*this) /= l;
 }
 
 
+LongInt LongInt::operator/(const LongInt & l) &&
+{
+    return std::move(*this /= l);
+}
+
+
 LongInt & LongInt::operator%=(const LongInt & l)
 {
-    return *this -= (l * (*this / l));
+    stats_op(STAT_MOD, x_.size());
+    LongInt quotient;
+    divmod(l, quotient, *this);
+
+    return *this;
 }
 
 
-LongInt LongInt::operator%(const LongInt & l) const
+LongInt LongInt::operator%(const LongInt & l) const &
 {
     return LongInt(*this) %= l;
 }
 
 
-LongInt LongInt::abs() const
+LongInt LongInt::operator%(const LongInt & l) &&
 {
-    LongInt ret = *this;
-    
-    if (ret.sign() == -1)
-        ret.sign() *= -1;
-
-    return ret;
+    return std::move(*this %= l);
 }
 
 
-LongInt & LongInt::multeq_tenpower(const int pow)
+LongInt & LongInt::operator<<=(const int s)
 {
-    if (pow > 0 && *this != 0)
-        for (int i = 0; i < pow; i++)
-            x_.insert(x_.begin(), 0);
+    if (s < 0)
+        return *this >>= -s;
+    stats_op(STAT_SHIFT, x_.size());
+    if (x_.empty() || s == 0)
+        return *this;
 
-    else
-    {
-        for (int i = 0; i > pow; i--)
-        {
-            if (x_.size() == 1)
-            {
-                *this = 0;
-                break;
-            }
+    const int w = s / LIMB_BITS, n = x_.size();
+    const unsigned b = s % LIMB_BITS;
+
+    //One move for the whole limbs, then one pass for the bits.
+    x_.resize(n + w + 1);
+    limb_t * d = x_.data();
+    std::copy_backward(d, d + n, d + n + w);
+    std::fill(d, d + w, 0);
+    if (b != 0)
+        d[n + w] = limbs_lshift(d + w, d + w, n, b);
+    trim();
 
-            x_.erase(x_.begin());
-        }
-    }
-    
     return *this;
 }
 
 
-LongInt & LongInt::multeq_digit(const int mult)
+LongInt LongInt::operator<<(const int s) const
 {
-    if (mult == 0)
-    {
-        *this = LongInt(0);
-        return *this;
-    }
-    
-    for (int i = 0; i < x_.size(); i++)
-        x_[i] *= mult;
+    LongInt ret(*this);
+    ret <<= s;
 
-    //-= 0 will correct overflow and negatives, if any.
-    return *this -= 0;
+    return ret;
 }
 
 
-int LongInt::int_val() const
+LongInt & LongInt::operator>>=(const int s)
 {
-    if (*this > INT_MAX || *this < INT_MIN)
+    if (s < 0)
+        return *this <<= -s;
+    stats_op(STAT_SHIFT, x_.size());
+    if (x_.empty() || s == 0)
+        return *this;
+
+    const int w = s / LIMB_BITS, n = x_.size();
+    const unsigned b = s % LIMB_BITS;
+    if (w >= n)
     {
-        throw IntConversionOverflowError();
+        *this = (sign_ == -1 ? -1 : 0);
+        return *this;
     }
-    
-    int ret = 0;
-    for (int i = 0, j; i < x_.size(); i++)
+
+    //A negative number rounds down, so if any one bits are
+    //shifted out its magnitude goes up by one.
+    bool round = false;
+    if (sign_ == -1)
     {
-        if (x_[i] != 0)
-        {
-            j = 1;
-            for(int k = 0; k < i; k++)
-                j *= 10;
-            ret += (x_[i]) * j;
-        }
+        for (int i = 0; i < w && !round; i++)
+            round = (x_[i] != 0);
+        if (b != 0 && (x_[w] << (LIMB_BITS - b)) != 0)
+            round = true;
     }
 
-    if (sign_ == -1)
-        ret *= -1;
+    limb_t * d = x_.data();
+    std::copy(d + w, d + n, d);
+    if (b != 0)
+        limbs_rshift(d, d, n - w, b);
+    x_.resize(n - w);
+
+    if (round)
+    {
+        x_.push_back(0);
+        limbs_add_1(x_.data(), x_.data(), x_.size(), 1);
+    }
+    trim();
+
+    return *this;
+}
+
+
+LongInt LongInt::operator>>(const int s) const
+{
+    LongInt ret(*this);
+    ret >>= s;
 
     return ret;
 }
 
 
-LongInt::operator int() const
+LongInt & LongInt::operator&=(const LongInt & l)
 {
-    return int_val();
+    return bitwise(l, '&');
 }
 
 
-/////////////////
-///NON-MEMBERS///
-/////////////////
+LongInt LongInt::operator&(const LongInt & l) const
+{
+    LongInt ret(*this);
+    ret.bitwise(l, '&');
 
+    return ret;
+}
 
-bool operator==(const int i, const LongInt & l)
+
+LongInt & LongInt::operator|=(const LongInt & l)
 {
-    return l == i;
+    return bitwise(l, '|');
 }
 
 
-bool operator!=(const int i, const LongInt & l)
+LongInt LongInt::operator|(const LongInt & l) const
 {
-    return l != i;
+    LongInt ret(*this);
+    ret.bitwise(l, '|');
+
+    return ret;
 }
 
 
-bool operator>(const int i, const LongInt & l)
+LongInt & LongInt::operator^=(const LongInt & l)
 {
-    return !(l <= i);
+    return bitwise(l, '^');
 }
 
 
-bool operator>=(const int i, const LongInt & l)
+LongInt LongInt::operator^(const LongInt & l) const
 {
-    return !(l < i);
+    LongInt ret(*this);
+    ret.bitwise(l, '^');
+
+    return ret;
 }
 
 
-bool operator<(const int i, const LongInt & l)
+LongInt LongInt::operator~() const
 {
-    return !(l >= i);
+    //~x = -(x + 1).
+    LongInt ret(*this);
+    ret += 1;
+    if (ret != 0)
+        ret.sign_ *= -1;
+
+    return ret;
 }
 
 
-bool operator<=(const int i, const LongInt & l)
+void LongInt::divmod(const LongInt & l, LongInt & quotient,
+                     LongInt & remainder) const
 {
-    return !(l > i);
+    if (l == 0)
+        throw DivideByZeroError();
+    stats_op(STAT_DIVMOD, x_.size());
+
+    int q_sign = (sign_ != l.sign() ? -1 : 1), r_sign = sign_;
+    LimbArr q, r;
+
+    if (x_.size() <= SMALL_LIMBS && l.x_.size() <= SMALL_LIMBS)
+    {
+        small_t a = load_small(x_), b = load_small(l.x_);
+        store_small(q, a / b);
+        store_small(r, a % b);
+    }
+
+    else if (limbs_cmp(x_.data(), x_.size(), l.x_.data(), l.x_.size()) < 0)
+        r = x_;
+
+    else
+    {
+        q.resize(x_.size() - l.x_.size() + 1);
+        r.resize(l.x_.size());
+        limbs_divrem(q.data(), r.data(), x_.data(), x_.size(),
+                     l.x_.data(), l.x_.size());
+    }
+
+    //Everything is read, so it is now safe for either result
+    //to be this LongInt or l.
+    quotient.x_.swap(q);
+    quotient.sign_ = q_sign;
+    quotient.trim();
+
+    remainder.x_.swap(r);
+    remainder.sign_ = r_sign;
+    remainder.trim();
+
+    return;
 }
 
 
-LongInt operator+(const int i, const LongInt & l)
+LongInt & LongInt::assign_fma(const LongInt & a, const LongInt & b,
+                              const LongInt & c, const int c_sign)
 {
-    return l + i;
+    const int p_sign = a.sign_ * b.sign_, cs = c.sign_ * c_sign;
+    stats_op(STAT_FMA, std::max(a.x_.size(), b.x_.size()));
+
+    //Opposite signs would need a subtraction in the middle of
+    //the product, so do them one after the other.
+    if (a.x_.empty() || b.x_.empty() || (cs != p_sign && !c.x_.empty()))
+    {
+        LongInt ret = a * b;
+        ret.add_signed(c, cs);
+        *this = std::move(ret);
+
+        return *this;
+    }
+
+    const LimbArr & big = (a.x_.size() >= b.x_.size() ? a.x_ : b.x_);
+    const LimbArr & small = (a.x_.size() >= b.x_.size() ? b.x_ : a.x_);
+
+    //One spare limb so the sum never carries out.
+    LimbArr r(c.x_);
+    r.resize(std::max(big.size() + small.size(), c.x_.size()) + 1);
+    limbs_addmul(r.data(), r.size(), big.data(), big.size(),
+                 small.data(), small.size());
+
+    //a, b and c are all read, so this may be any of them.
+    x_.swap(r);
+    sign_ = p_sign;
+    trim();
+
+    return *this;
 }
 
 
-LongInt operator-(const int i, const LongInt & l)
+LongInt & LongInt::assign_mulmod(const LongInt & a, const LongInt & b,
+                                 const LongInt & m)
 {
-    return LongInt(i) - l;
+    if (m == 0)
+        throw DivideByZeroError();
+    stats_op(STAT_MULMOD, std::max(a.x_.size(), b.x_.size()));
+
+    const int p_sign = a.sign_ * b.sign_;
+    LimbArr r;
+
+    if (a.x_.size() <= SMALL_LIMBS / 2 && b.x_.size() <= SMALL_LIMBS / 2 &&
+        m.x_.size() <= SMALL_LIMBS)
+    {
+        store_small(r, load_small(a.x_) * load_small(b.x_) % load_small(m.x_));
+    }
+
+    else if (!a.x_.empty() && !b.x_.empty())
+    {
+        const LimbArr & big = (a.x_.size() >= b.x_.size() ? a.x_ : b.x_);
+        const LimbArr & small = (a.x_.size() >= b.x_.size() ? b.x_ : a.x_);
+
+        LimbArr prod(big.size() + small.size());
+        limbs_mul(prod.data(), big.data(), big.size(),
+                  small.data(), small.size());
+        int pn = limbs_normalize(prod.data(), prod.size());
+
+        //Only the remainder is kept, the quotient limbs are
+        //scratch.
+        if (limbs_cmp(prod.data(), pn, m.x_.data(), m.x_.size()) < 0)
+        {
+            prod.resize(pn);
+            r.swap(prod);
+        }
+        else
+        {
+            LimbArr q(pn - m.x_.size() + 1);
+            r.resize(m.x_.size());
+            limbs_divrem(q.data(), r.data(), prod.data(), pn,
+                         m.x_.data(), m.x_.size());
+        }
+    }
+
+    x_.swap(r);
+    sign_ = p_sign;
+    trim();
+
+    return *this;
 }
 
 
-LongInt operator*(const int i, const LongInt & l)
+LongInt & LongInt::assign_gcd(const LongInt & a, const LongInt & b)
 {
-    return l * i;
+    stats_op(STAT_GCD, std::max(a.x_.size(), b.x_.size()));
+    LimbArr g;
+
+    if (a.x_.empty())
+        g = b.x_;
+    else if (b.x_.empty())
+        g = a.x_;
+    else
+    {
+        g.resize(std::min(a.x_.size(), b.x_.size()));
+        g.resize(limbs_gcd(g.data(), a.x_.data(), a.x_.size(),
+                           b.x_.data(), b.x_.size()));
+    }
+
+    x_.swap(g);
+    sign_ = 1;
+    trim();
+
+    return *this;
 }
 
 
-LongInt operator/(const int i, const LongInt & l)
+LongInt & LongInt::assign_gcdext(const LongInt & a, const LongInt & b,
+                                 LongInt & s, LongInt & t)
 {
-    return l / i;
+    stats_op(STAT_GCD, std::max(a.x_.size(), b.x_.size()));
+    LongInt g, s_val, t_val;
+
+    if (b.x_.empty())
+    {
+        g = a.abs();
+        s_val = (a.x_.empty() ? 0 : a.sign_);
+    }
+
+    else if (a.x_.empty())
+    {
+        g = b.abs();
+        t_val = b.sign_;
+    }
+
+    else
+    {
+        //The kernel works on magnitudes, so s picks up a's sign
+        //and t comes from g = s * a + t * b.
+        int sn;
+        g.x_.resize(std::min(a.x_.size(), b.x_.size()));
+        s_val.x_.resize(b.x_.size());
+        g.x_.resize(limbs_gcdext(g.x_.data(), s_val.x_.data(), &sn,
+                                 a.x_.data(), a.x_.size(),
+                                 b.x_.data(), b.x_.size()));
+        s_val.x_.resize(sn < 0 ? -sn : sn);
+        s_val.sign_ = (sn < 0 ? -1 : 1) * a.sign_;
+        s_val.trim();
+
+        t_val = (g - s_val * a) / b;
+    }
+
+    s = std::move(s_val);
+    t = std::move(t_val);
+    *this = std::move(g);
+
+    return *this;
 }
 
 
-int & operator+=(int & i, const LongInt & l)
+LongInt & LongInt::assign_root(const LongInt & a, const int k)
 {
-    return i += l.int_val();
+    if (k < 1 || (a.sign_ == -1 && k % 2 == 0))
+        throw InvalidRootError();
+    stats_op(STAT_ROOT, a.x_.size());
+
+    //An odd root of a negative number is minus the root of its
+    //magnitude, which rounds toward zero.
+    LimbArr r;
+    if (!a.x_.empty())
+    {
+        r.resize(a.x_.size() / k + 1);
+        r.resize(limbs_root(r.data(), a.x_.data(), a.x_.size(), k));
+    }
+
+    x_.swap(r);
+    sign_ = a.sign_;
+    trim();
+
+    return *this;
 }
 
 
-int & operator-=(int & i, const LongInt & l)
+LongInt LongInt::abs() const
 {
-    return i -= l.int_val();
+    LongInt ret = *this;
+    
+    if (ret.sign() == -1)
+        ret.sign() *= -1;
+
+    return ret;
 }
 
 
-int & operator*=(int & i, const LongInt & l)
+int LongInt::popcount() const
 {
-    return i *= l.int_val();
+    return limbs_popcount(x_.data(), x_.size());
 }
 
 
-int & operator/=(int & i, const LongInt & l)
+int LongInt::bit_length() const
 {
-    return i /= l.int_val();
+    if (x_.empty())
+        return 0;
+
+    int bits = (x_.size() - 1) * LIMB_BITS;
+    for (limb_t top = x_.back(); top != 0; top >>= 1)
+        bits++;
+
+    return bits;
 }
 
 
-int & operator%=(int & i, const LongInt & l)
+bool LongInt::test_bit(const int i) const
 {
-    return i %= l.int_val();
+    if (i < 0)
+        return false;
+
+    const int w = i / LIMB_BITS;
+    const bool bit = w < static_cast<int>(x_.size()) &&
+        ((x_[w] >> (i % LIMB_BITS)) & 1);
+    if (sign_ == 1)
+        return bit;
+
+    //-m is ~(m - 1), and m - 1 is m with its lowest one bit
+    //cleared and every bit below it set.
+    int low = 0;
+    while (x_[low / LIMB_BITS] == 0)
+        low += LIMB_BITS;
+    while (!((x_[low / LIMB_BITS] >> (low % LIMB_BITS)) & 1))
+        low++;
+
+    if (i <= low)
+        return i == low;
+
+    return !bit;
 }
 
 
-LongInt abs(LongInt & l)
+LongInt & LongInt::multeq_tenpower(const int pow)
 {
-    return l.abs();
+    if (pow > 0 && *this != 0)
+    {
+        //Multiply by 10^9 as many times as we can, then by
+        //whatever power is left over.
+        for (int i = 0; i < pow; i += DEC_CHUNK_DIGITS)
+        {
+            limb_t scale = DEC_CHUNK;
+            for (int j = pow - i; j < DEC_CHUNK_DIGITS; j++)
+                scale /= 10;
+
+            limb_t carry = limbs_mul_1(x_.data(), x_.data(), x_.size(), scale);
+            if (carry != 0)
+                x_.push_back(carry);
+        }
+        forget_caches();
+    }
+
+    else
+    {
+        //Dividing drops the low digits, same as
+        //erasing them did.
+        for (int i = 0; i > pow && !x_.empty(); i -= DEC_CHUNK_DIGITS)
+        {
+            limb_t scale = DEC_CHUNK;
+            for (int j = i - pow; j < DEC_CHUNK_DIGITS; j++)
+                scale /= 10;
+
+            limbs_divrem_1(x_.data(), x_.data(), x_.size(), scale);
+            trim();
+        }
+    }
+    
+    return *this;
 }
 
 
-std::ostream & operator<<(std::ostream & cout, const LongInt & l)
+LongInt & LongInt::multeq_digit(const int mult)
 {
-    if (l.sign() == -1)
-        cout << '-';
-    for (int i = 0; i < l.size(); i++)
-        cout << l[i];
+    if (mult == 0)
+    {
+        *this = LongInt(0);
+        return *this;
+    }
+
+    limb_t m = static_cast<limb_t>(mult);
+    if (mult < 0)
+    {
+        m = 0 - m;
+        sign_ *= -1;
+    }
+
+    limb_t carry = limbs_mul_1(x_.data(), x_.data(), x_.size(), m);
+    if (carry != 0)
+        x_.push_back(carry);
+
+    //Fixes the sign if this was zero.
+    trim();
+
+    return *this;
+}
+
+
+int LongInt::int_val() const
+{
+    if (*this > INT_MAX || *this < INT_MIN)
+    {
+        throw IntConversionOverflowError();
+    }
+
+    return static_cast<int>(to_int64());
+}
+
+
+LongInt::operator int() const
+{
+    return int_val();
+}
+
+
+std::int64_t LongInt::to_int64() const
+{
+    if (*this > INT64_MAX || *this < INT64_MIN)
+        throw IntConversionOverflowError();
+
+    //Negating as unsigned keeps INT64_MIN working.
+    std::uint64_t ret = load_small(x_);
+    if (sign_ == -1)
+        ret = 0 - ret;
+
+    return static_cast<std::int64_t>(ret);
+}
+
+
+std::uint64_t LongInt::to_uint64() const
+{
+    if (sign_ == -1 || *this > UINT64_MAX)
+        throw IntConversionOverflowError();
+
+    return load_small(x_);
+}
+
+
+std::size_t LongInt::hash() const
+{
+    std::uint32_t h = hash_.load(std::memory_order_relaxed);
+    if (h == 0)
+    {
+        //Racing threads all work out the same value, so whichever
+        //store lands is fine.
+        const std::uint64_t full = limbs_hash(x_.data(), x_.size(),
+                                              hash_seed());
+        h = static_cast<std::uint32_t>(full ^ (full >> 32));
+        if (h == 0)
+            h = 1;
+        hash_.store(h, std::memory_order_relaxed);
+    }
+
+    //Spread the 32 bits back over a whole word, so tables that
+    //take their bucket from the high bits get good ones too.
+    if (sign_ == -1)
+        h = ~h;
+
+    return static_cast<std::size_t>(h * HASH_SPREAD);
+}
+
+
+std::uint64_t LongInt::hash(const std::uint64_t seed) const
+{
+    const std::uint64_t h = limbs_hash(x_.data(), x_.size(), seed);
+    return (sign_ == -1 ? ~h : h);
+}
+
+
+std::string LongInt::to_string(const int base) const
+{
+    std::string ret(1 + (base == 16 ? limbs_hex_size(x_.size())
+                         : limbs_dec_size(x_.size())), '0');
+
+    std::to_chars_result res = ::to_chars(&ret[0], &ret[0] + ret.size(),
+                                          *this, base);
+    if (res.ec != std::errc())
+        throw InvalidBaseError();
+
+    ret.resize(res.ptr - &ret[0]);
+
+    return ret;
+}
+
+
+LongInt & LongInt::bitwise(const LongInt & l, const char op)
+{
+    stats_op(STAT_BITWISE, std::max(x_.size(), l.x_.size()));
+
+    //Two non negative numbers need no conversion. Limbs past the
+    //end of the shorter one are zero, which & clears and | and ^
+    //copy.
+    if (sign_ == 1 && l.sign_ == 1)
+    {
+        const int n = std::min(x_.size(), l.x_.size());
+        if (op == '&')
+        {
+            x_.resize(n);
+            limbs_and_n(x_.data(), x_.data(), l.x_.data(), n);
+        }
+
+        else
+        {
+            if (x_.size() < l.x_.size())
+                x_.resize(l.x_.size());
+
+            if (op == '|')
+                limbs_ior_n(x_.data(), x_.data(), l.x_.data(), l.x_.size());
+            else
+                limbs_xor_n(x_.data(), x_.data(), l.x_.data(), l.x_.size());
+        }
+
+        trim();
+        return *this;
+    }
+
+    //Otherwise in two's complement, with a limb to spare for the
+    //sign bit.
+    const int n = std::max(x_.size(), l.x_.size()) + 1;
+    LimbArr a(n), b(n);
+    load_twos(a, x_, sign_);
+    load_twos(b, l.x_, l.sign_);
+
+    if (op == '&')
+        limbs_and_n(a.data(), a.data(), b.data(), n);
+    else if (op == '|')
+        limbs_ior_n(a.data(), a.data(), b.data(), n);
+    else
+        limbs_xor_n(a.data(), a.data(), b.data(), n);
+
+    sign_ = store_twos(a);
+    x_.swap(a);
+    trim();
+
+    return *this;
+}
+
+
+LongInt & LongInt::add_signed(const LongInt & l, const int l_sign)
+{
+    if (small_add(x_, sign_, l.x_, l_sign))
+    {
+        trim();
+        return *this;
+    }
+
+    int l_size = l.x_.size();
+    if (sign_ == l_sign)
+    {
+        //Add zeros in unfilled spaces, if any, plus one
+        //for the carry.
+        if (l_size > x_.size())
+            x_.resize(l_size);
+        x_.push_back(0);
+
+        //Add values. l may be *this, so only take its limbs
+        //after resizing.
+        x_.back() = limbs_add(x_.data(), x_.data(), x_.size() - 1,
+                              l.x_.data(), l_size);
+    }
+
+    else if (limbs_cmp(x_.data(), x_.size(), l.x_.data(), l_size) >= 0)
+    {
+        limbs_sub(x_.data(), x_.data(), x_.size(), l.x_.data(), l_size);
+    }
+
+    //l is bigger, so the result is l - this with the
+    //sign swapped.
+    else
+    {
+        x_.resize(l_size);
+        limbs_sub_n(x_.data(), l.x_.data(), x_.data(), l_size);
+        sign_ *= -1;
+    }
+
+    //Remove redundant zeros. If it is all just zeros
+    //the sign goes back to positive.
+    trim();
+
+    return *this;
+}
+
+
+void LongInt::trim()
+{
+    while (!x_.empty() && x_.back() == 0)
+        x_.pop_back();
+
+    if (x_.empty())
+        sign_ = 1;
+
+    forget_caches();
+
+    return;
+}
+
+
+void LongInt::assign_int64(const std::int64_t i)
+{
+    //Negate as unsigned so INT64_MIN works.
+    std::uint64_t mag = static_cast<std::uint64_t>(i);
+    if (i < 0)
+        mag = 0 - mag;
+
+    forget_caches();
+    store_small(x_, mag);
+    sign_ = (i < 0 ? -1 : 1);
+
+    return;
+}
+
+
+void LongInt::assign_uint64(const std::uint64_t i)
+{
+    forget_caches();
+    store_small(x_, i);
+    sign_ = 1;
+
+    return;
+}
+
+
+int LongInt::compare_int64(const std::int64_t i) const
+{
+    if (i >= 0)
+        return compare_uint64(static_cast<std::uint64_t>(i));
+
+    //Zero is positive, so a different sign settles it.
+    if (sign_ == 1)
+        return 1;
+
+    //Both negative: the bigger magnitude is the smaller number.
+    const std::uint64_t mag = 0 - static_cast<std::uint64_t>(i);
+    if (x_.size() > SMALL64_LIMBS)
+        return -1;
+
+    const std::uint64_t x = load_small(x_);
+
+    return (x > mag ? -1 : (x < mag ? 1 : 0));
+}
+
+
+int LongInt::compare_uint64(const std::uint64_t i) const
+{
+    if (sign_ == -1)
+        return -1;
+
+    if (x_.size() > SMALL64_LIMBS)
+        return 1;
+
+    const std::uint64_t x = load_small(x_);
+
+    return (x > i ? 1 : (x < i ? -1 : 0));
+}
+
+
+std::string LongInt::digits() const
+{
+    std::string ret(limbs_dec_size(x_.size()), '0');
+    ret.resize(limbs_to_dec(&ret[0], x_.data(), x_.size()));
+
+    return ret;
+}
+
+
+LongInt::DigitCache & LongInt::digit_cache() const
+{
+    DigitCache * c = dec_.load(std::memory_order_acquire);
+    if (c != nullptr)
+        return *c;
+
+    std::unique_ptr<DigitCache> made(new DigitCache);
+    const bool small = limbs_dec_size(x_.size()) <= 2 * DIGIT_CHUNK;
+    if (small)
+        made->digits = digits();
+    else
+        made->digits.assign(decimal_size(), '0');
+
+    made->size = made->digits.size();
+    made->chunks = std::max((made->size + DIGIT_CHUNK - 1) / DIGIT_CHUNK, 1);
+    made->ready.reset(new std::atomic<bool>[made->chunks]());
+    for (int k = 0; k < made->chunks; k++)
+        made->ready[k] = small;
+
+    //Another thread may have got there first.
+    if (dec_.compare_exchange_strong(c, made.get(),
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire))
+        return *made.release();
+
+    return *c;
+}
+
+
+void LongInt::fill_digits(DigitCache & c, const int k) const
+{
+    std::lock_guard<std::mutex> guard(c.lock);
+    if (c.ready[k].load(std::memory_order_relaxed))
+        return;
+
+    //A middle chunk costs as much as a good part of the whole
+    //conversion, and whoever wants one is likely walking through
+    //the digits, so convert the rest in one go. Chunks already
+    //there may be being read, so they are left alone.
+    if (k != 0 && k != c.chunks - 1)
+    {
+        std::string all = digits();
+        for (int j = 0; j < c.chunks; j++)
+        {
+            if (c.ready[j].load(std::memory_order_relaxed))
+                continue;
+
+            const int end = c.size - j * DIGIT_CHUNK;
+            const int begin = std::max(end - DIGIT_CHUNK, 0);
+            std::copy(all.begin() + begin, all.begin() + end,
+                      c.digits.begin() + begin);
+            c.ready[j].store(true, std::memory_order_release);
+        }
+
+        return;
+    }
+
+    //Chunk k is |x| / 10^(k * DIGIT_CHUNK) mod 10^DIGIT_CHUNK. At
+    //either end one of the two steps drops out, and the other is a
+    //division with a short quotient or a short divisor.
+    LongInt q = abs();
+    if (k > 0)
+        q /= pow(LongInt(10), k * DIGIT_CHUNK);
+    if (k < c.chunks - 1)
+        q %= pow(LongInt(10), DIGIT_CHUNK);
+
+    const std::string part = q.digits();
+    const int end = c.size - k * DIGIT_CHUNK;
+    std::copy(part.begin(), part.end(), c.digits.begin() + end - part.size());
+
+    c.ready[k].store(true, std::memory_order_release);
+
+    return;
+}
+
+
+//Number of digits from the bit length, checked against one power
+//of ten. x < 2^bits, so there are at most one more digit than
+//2^(bits - 1) has.
+int LongInt::decimal_size() const
+{
+    const int bits = bit_length();
+    int d = static_cast<int>((bits - 1) * 0.30102999566398119521) + 1;
+
+    LongInt m = abs(), p = pow(LongInt(10), d);
+    while (m >= p)
+    {
+        p.multeq_digit(10);
+        d++;
+    }
+
+    //Only if the estimate was too big.
+    p /= 10;
+    while (d > 1 && m < p)
+    {
+        p /= 10;
+        d--;
+    }
+
+    return d;
+}
+
+
+void LongInt::forget_caches()
+{
+    hash_.store(0, std::memory_order_relaxed);
+
+    DigitCache * c = dec_.load(std::memory_order_relaxed);
+    if (c != nullptr)
+    {
+        dec_.store(nullptr, std::memory_order_relaxed);
+        delete c;
+    }
+
+    return;
+}
+
+
+/////////////////
+///NON-MEMBERS///
+/////////////////
+
+
+LongInt operator+(const int i, const LongInt & l)
+{
+    return l + i;
+}
+
+
+LongInt operator-(const int i, const LongInt & l)
+{
+    return LongInt(i) - l;
+}
+
+
+LongInt operator*(const int i, const LongInt & l)
+{
+    return l * i;
+}
+
+
+LongInt operator/(const int i, const LongInt & l)
+{
+    return l / i;
+}
+
+
+int & operator+=(int & i, const LongInt & l)
+{
+    return i += l.int_val();
+}
+
+
+int & operator-=(int & i, const LongInt & l)
+{
+    return i -= l.int_val();
+}
+
+
+int & operator*=(int & i, const LongInt & l)
+{
+    return i *= l.int_val();
+}
+
+
+int & operator/=(int & i, const LongInt & l)
+{
+    return i /= l.int_val();
+}
+
+
+int & operator%=(int & i, const LongInt & l)
+{
+    return i %= l.int_val();
+}
+
+
+LongInt abs(LongInt & l)
+{
+    return l.abs();
+}
+
+
+LongInt fma(const LongInt & a, const LongInt & b, const LongInt & c)
+{
+    LongInt ret;
+    ret.assign_fma(a, b, c);
+
+    return ret;
+}
+
+
+LongInt mulmod(const LongInt & a, const LongInt & b, const LongInt & m)
+{
+    LongInt ret;
+    ret.assign_mulmod(a, b, m);
+
+    return ret;
+}
+
+
+LongInt gcd(const LongInt & a, const LongInt & b)
+{
+    LongInt ret;
+    ret.assign_gcd(a, b);
+
+    return ret;
+}
+
+
+LongInt gcdext(const LongInt & a, const LongInt & b, LongInt & s,
+               LongInt & t)
+{
+    LongInt ret;
+    ret.assign_gcdext(a, b, s, t);
+
+    return ret;
+}
+
+
+LongInt modinv(const LongInt & a, const LongInt & m)
+{
+    if (m == 0)
+        throw DivideByZeroError();
+
+    LongInt s, t;
+    if (gcdext(a, m, s, t) != 1)
+        throw NotInvertibleError();
+
+    const LongInt m_abs = m.abs();
+    s %= m_abs;
+    if (s.sign() == -1)
+        s += m_abs;
+
+    return s;
+}
+
+
+LongInt isqrt(const LongInt & a)
+{
+    return iroot(a, 2);
+}
+
+
+LongInt iroot(const LongInt & a, const int k)
+{
+    LongInt ret;
+    ret.assign_root(a, k);
+
+    return ret;
+}
+
+
+bool is_perfect_square(const LongInt & a)
+{
+    if (a.sign() == -1)
+        return false;
+    if (a == 0)
+        return true;
+
+    //Most non squares are caught by their residues mod 64, 63, 65
+    //and 11 before taking the root.
+    if (!is_square_mod(a.limbs()[0] % 64, 64))
+        return false;
+
+    LimbArr q(a.limb_count());
+    limb_t r = limbs_divrem_1(q.data(), a.limbs(), a.limb_count(),
+                              63 * 65 * 11);
+    if (!is_square_mod(r % 63, 63) || !is_square_mod(r % 65, 65) ||
+        !is_square_mod(r % 11, 11))
+        return false;
+
+    LongInt root = isqrt(a);
+
+    return root * root == a;
+}
+
+
+bool is_perfect_power(const LongInt & a)
+{
+    const int n = a.limb_count();
+    const limb_t * x = a.limbs();
+    if (n == 0 || (n == 1 && x[0] == 1))
+        return true;
+
+    //|a| = 2^zeros m with m odd. If |a| = b^k then k divides zeros
+    //and m is a k-th power too, and only prime k need trying.
+    int zeros = 0;
+    while (x[zeros / LIMB_BITS] == 0)
+        zeros += LIMB_BITS;
+    for (limb_t low = x[zeros / LIMB_BITS]; !(low & 1); low >>= 1)
+        zeros++;
+
+    const LongInt m = a.abs() >> zeros;
+    const int m_bits = m.bit_length();
+    small_t m_low = 0;
+    for (int i = std::min(m.limb_count(), SMALL_LIMBS) - 1; i >= 0; i--)
+        m_low = (m_low << LIMB_BITS) | m.limbs()[i];
+    const double m_log = log2_mantissa(m);
+
+    //An odd m > 1 is at least 3^k, and m = 1 is a k-th power for
+    //every k dividing zeros.
+    int k_max = (m_bits == 1 ? zeros : m_bits);
+    if (zeros != 0)
+        k_max = std::min(k_max, zeros);
+
+    std::vector<bool> composite(k_max + 1);
+    limb_t res[SCREEN_COUNT];
+    bool screened = false;
+    for (int k = 2; k <= k_max; k++)
+    {
+        if (composite[k])
+            continue;
+        for (dlimb_t j = static_cast<dlimb_t>(k) * k;
+             j <= static_cast<dlimb_t>(k_max); j += k)
+            composite[j] = true;
+
+        if (zeros % k != 0)
+            continue;
+
+        //A negative a can only be an odd power.
+        if (k == 2)
+        {
+            if (a.sign() == 1 && is_perfect_square(a))
+                return true;
+            continue;
+        }
+
+        //For odd k the only candidate root below 2^e comes from the
+        //bottom bits of m, so just that one is built, natively when
+        //it is short enough. The full power is only taken when the
+        //candidate's top bits agree with m's.
+        const int e = (m_bits + k - 1) / k;
+        small_t r = root_small(m_low, k, std::min(e, SMALL_BITS));
+        LongInt root;
+        int root_bits = 0;
+        double root_log = 0;
+        if (e <= SMALL_BITS)
+        {
+            if (e < SMALL_BITS)
+                r &= (small_t(1) << e) - 1;
+            for (small_t t = r; t != 0; t >>= 1)
+                root_bits++;
+            root_log = std::log2(std::ldexp(static_cast<double>(r),
+                                            1 - root_bits));
+        }
+        else
+        {
+            if (!screened)
+            {
+                screen_residues(m, SCREEN_PRIMES, SCREEN_COUNT, res);
+                screened = true;
+            }
+
+            int tried = 0;
+            if (!passes_screen(SCREEN_PRIMES, SCREEN_COUNT, res, k, tried))
+                continue;
+
+            //The table has little to say about bigger k. Primes of
+            //k's own take a pass over m each, which only pays when
+            //the root is long enough to be slow to lift.
+            if (tried < 2 && e >= k && !passes_own_screen(m, k))
+                continue;
+
+            root = root_mod_2exp(m, k, r, e);
+            root_bits = root.bit_length();
+            root_log = log2_mantissa(root);
+        }
+
+        //m = root^k needs log2 m = k log2 root.
+        const long long d = (m_bits - 1)
+            - static_cast<long long>(k) * (root_bits - 1);
+        if (std::abs(k * root_log - m_log - d) > 1e-9 * k)
+            continue;
+
+        if (e <= SMALL_BITS)
+            root = small_to_long(r);
+        if (pow(root, k) == m)
+            return true;
+    }
+
+    return false;
+}
+
+
+LongInt pow(const LongInt & base, const int exp)
+{
+    if (exp < 0)
+        throw NegativeExponentError();
+    stats_op(STAT_POW, base.limb_count());
+
+    //Left to right over the bits of exp.
+    LongInt ret = 1;
+    for (int bit = 30; bit >= 0; bit--)
+    {
+        if (ret != 1)
+            ret *= ret;
+        if ((exp >> bit) & 1)
+            ret *= base;
+    }
+
+    return ret;
+}
+
+
+LongInt product_tree(std::vector<LongInt> & v)
+{
+    if (v.empty())
+        return 1;
+
+    //Multiply neighbours level by level, keeping the results at
+    //the front.
+    for (int n = v.size(); n > 1; n = (n + 1) / 2)
+    {
+        for (int i = 0; i + 1 < n; i += 2)
+            v[i / 2] = std::move(v[i]) * std::move(v[i + 1]);
+        if (n % 2 == 1)
+            v[n / 2] = std::move(v[n - 1]);
+    }
+
+    return std::move(v[0]);
+}
+
+
+LongInt factorial(const int n)
+{
+    if (n < 0)
+        throw NegativeArgumentError();
+
+    //n! = 2^twos times the odd parts of 2..n. The odd parts are
+    //packed several to an int before going into the tree.
+    std::vector<LongInt> v;
+    dlimb_t packed = 1;
+    int twos = 0;
+    for (int i = 2; i <= n; i++)
+    {
+        int odd = i;
+        for (; odd % 2 == 0; odd /= 2)
+            twos++;
+
+        if (packed * odd > INT_MAX)
+        {
+            v.push_back(static_cast<int>(packed));
+            packed = 1;
+        }
+        packed *= odd;
+    }
+    v.push_back(static_cast<int>(packed));
+
+    return product_tree(v) << twos;
+}
+
+
+LongInt binomial(const LongInt & n, const int k)
+{
+    if (k < 0)
+        return 0;
+
+    if (n.sign() == -1)
+    {
+        LongInt ret = binomial(k - n - 1, k);
+        if (k % 2 == 1)
+            ret = 0 - ret;
+
+        return ret;
+    }
+
+    if (n < k)
+        return 0;
+
+    //C(n, k) = C(n, n - k), take the shorter product.
+    int j = k;
+    if (n - k < k)
+        j = (n - k).int_val();
+
+    //n (n - 1) ... (n - j + 1) / j!, which divides exactly.
+    std::vector<LongInt> v(j);
+    for (int i = 0; i < j; i++)
+        v[i] = n - i;
+
+    return product_tree(v) / factorial(j);
+}
+
+
+LongInt primorial(const int n)
+{
+    //Sieve of Eratosthenes, then the primes packed as in
+    //factorial.
+    std::vector<bool> composite(std::max(n + 1, 2));
+    std::vector<LongInt> v;
+    dlimb_t packed = 1;
+    for (int p = 2; p <= n; p++)
+    {
+        if (composite[p])
+            continue;
+
+        for (dlimb_t m = static_cast<dlimb_t>(p) * p;
+             m <= static_cast<dlimb_t>(n); m += p)
+            composite[m] = true;
+
+        if (packed * p > INT_MAX)
+        {
+            v.push_back(static_cast<int>(packed));
+            packed = 1;
+        }
+        packed *= p;
+    }
+    v.push_back(static_cast<int>(packed));
+
+    return product_tree(v);
+}
+
+
+std::ostream & operator<<(std::ostream & cout, const LongInt & l)
+{
+    return cout << l.to_string();
+}
+
+
+std::to_chars_result to_chars(char * first, char * last, const LongInt & l,
+                              const int base)
+{
+    if (base != 10 && base != 16)
+        return { last, std::errc::invalid_argument };
+    stats_op(STAT_PRINT, l.limb_count());
+
+    int n = l.limb_count(),
+        room = (base == 10 ? limbs_dec_size(n) : limbs_hex_size(n));
+
+    //Convert into our own buffer when the caller's might be too
+    //small, the size above is only an upper bound.
+    std::vector<char> buf;
+    char * out = first + (l.sign() == -1 ? 1 : 0);
+    if (last - out < room)
+    {
+        buf.resize(room);
+        out = buf.data();
+    }
+
+    int len = (base == 10 ? limbs_to_dec(out, l.limbs(), n)
+               : limbs_to_hex(out, l.limbs(), n));
+
+    if (last - first < len + (l.sign() == -1 ? 1 : 0))
+        return { last, std::errc::value_too_large };
+
+    if (l.sign() == -1)
+        *first++ = '-';
+    if (!buf.empty())
+        std::copy(buf.begin(), buf.begin() + len, first);
+
+    return { first + len, std::errc() };
+}
+
+
+std::from_chars_result from_chars(const char * first, const char * last,
+                                  LongInt & l, const int base)
+{
+    if (base != 10 && base != 16)
+        return { first, std::errc::invalid_argument };
+
+    const char * p = first;
+    int sign = 1;
+    if (p != last && *p == '-')
+    {
+        sign = -1;
+        p++;
+    }
+
+    //Find the run of digits.
+    const char * end = p;
+    while (end != last &&
+           ((*end >= '0' && *end <= '9') ||
+            (base == 16 && ((*end >= 'a' && *end <= 'f') ||
+                            (*end >= 'A' && *end <= 'F')))))
+    {
+        end++;
+    }
+
+    if (end == p)
+        return { first, std::errc::invalid_argument };
+
+    int len = end - p;
+    LimbArr x(base == 10 ? limbs_dec_limbs(len) : limbs_hex_limbs(len));
+    x.resize(base == 10 ? limbs_from_dec(x.data(), p, len)
+             : limbs_from_hex(x.data(), p, len));
+
+    stats_op(STAT_PARSE, x.size());
+    l.x_.swap(x);
+    l.sign_ = sign;
+    l.trim();
 
-    return cout;
+    return { end, std::errc() };
 }
@@ -7,7 +7,25 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <iterator> //for std::begin / std::end
+#include <charconv> //for to_chars_result / from_chars_result
+#include <functional> //for std::hash
 #include <climits> //for INT_MAX
+#include <cstdint>
+#include <type_traits>
+#include <atomic>
+
+#include "LimbOps.h"
+#include "LimbArr.h"
+
+//Integer types that LongInt converts from and compares against
+//straight from its limbs: every built in integer up to 64 bits.
+template<class T>
+struct is_machine_int :
+    std::integral_constant<bool, std::is_integral<T>::value &&
+                                 sizeof(T) <= sizeof(std::uint64_t)>
+{};
 
 class LongInt
 {
@@ -15,15 +33,39 @@ public:
     LongInt();
     LongInt(const char[]);
     LongInt(const int);
+    LongInt(const std::int64_t);
+    LongInt(const std::uint64_t);
+    //Any other integer type, so unsigned, long long and the like
+    //neither get truncated to an int nor leave the call ambiguous.
+    template<class T, class = typename std::enable_if<
+                          is_machine_int<T>::value>::type>
+    LongInt(const T i) : sign_(1)
+    {
+        if (std::is_signed<T>::value)
+            assign_int64(static_cast<std::int64_t>(i));
+        else
+            assign_uint64(static_cast<std::uint64_t>(i));
+        return;
+    }
+    LongInt(const LongInt&);
+    LongInt(LongInt&&) noexcept;
+    ~LongInt();
+    //From n limbs, least significant first, and a sign of 1 or -1.
+    LongInt(const limb_t*, const int, const int sign = 1);
 
-    inline
-    int size() const { return x_.size(); }
+    //Number of decimal digits. The value is stored in binary,
+    //so the first call works it out, from the bit length and one
+    //power of ten for big values, and later calls reuse it until
+    //the LongInt changes.
+    int size() const;
 
     //Operator[] returns the digit value at the i'th number
     //in the LongInt from left to right. So, if the LongInt
-    //l is "12345", then l[1] = 2.
-    inline
-    int operator[](const int i) const { return x_[(x_.size() - 1) - i]; }
+    //l is "12345", then l[1] = 2. Digits are converted and kept
+    //in chunks as they are asked for, so reading just the first
+    //or last few of a big value doesn't convert all of it, and
+    //walking every digit converts once.
+    int operator[](const int) const;
 
     //1 == positive, -1 == negative.
     inline
@@ -32,8 +74,12 @@ public:
     int& sign() { return sign_; }
 
     const LongInt& operator=(const LongInt&);
+    const LongInt& operator=(LongInt&&) noexcept;
     const LongInt& operator=(const char[]);
     const LongInt& operator=(const int);
+    template<class T, class = typename std::enable_if<
+                          is_machine_int<T>::value>::type>
+    const LongInt& operator=(const T i) { return *this = LongInt(i); }
 
     bool operator==(const LongInt&) const;
     bool operator!=(const LongInt&) const;
@@ -42,47 +88,227 @@ public:
     bool operator< (const LongInt&) const;
     bool operator<=(const LongInt&) const;
 
+    //Comparisons with a machine integer read the limbs directly
+    //rather than making a LongInt of it, so checks like l == 0 on
+    //the hot paths cost a couple of loads.
+    template<class T>
+    typename std::enable_if<is_machine_int<T>::value, bool>::type
+    operator==(const T i) const { return compare_int(i) == 0; }
+    template<class T>
+    typename std::enable_if<is_machine_int<T>::value, bool>::type
+    operator!=(const T i) const { return compare_int(i) != 0; }
+    template<class T>
+    typename std::enable_if<is_machine_int<T>::value, bool>::type
+    operator> (const T i) const { return compare_int(i) > 0; }
+    template<class T>
+    typename std::enable_if<is_machine_int<T>::value, bool>::type
+    operator>=(const T i) const { return compare_int(i) >= 0; }
+    template<class T>
+    typename std::enable_if<is_machine_int<T>::value, bool>::type
+    operator< (const T i) const { return compare_int(i) < 0; }
+    template<class T>
+    typename std::enable_if<is_machine_int<T>::value, bool>::type
+    operator<=(const T i) const { return compare_int(i) <= 0; }
+
+    //The binary operators have overloads for temporaries that
+    //reuse the temporary's limbs for the result instead of
+    //allocating, so a * b + c only allocates for a * b.
     LongInt & operator+=(const LongInt&);
-    LongInt   operator+(const LongInt&) const;
+    LongInt   operator+(const LongInt&) const &;
+    LongInt   operator+(const LongInt&) &&;
+    LongInt   operator+(LongInt&&) const &;
+    LongInt   operator+(LongInt&&) &&;
     LongInt   operator+() const;
     LongInt   operator++(const int);
     LongInt & operator++();
                       
     LongInt & operator-=(const LongInt&);
-    LongInt   operator-(const LongInt&) const;
+    LongInt   operator-(const LongInt&) const &;
+    LongInt   operator-(const LongInt&) &&;
     LongInt   operator-();
     LongInt   operator--(const int);
     LongInt & operator--();
 
     LongInt & operator*=(const LongInt&);
-    LongInt   operator*(const LongInt&) const;
+    LongInt   operator*(const LongInt&) const &;
+    LongInt   operator*(const LongInt&) &&;
+    LongInt   operator*(LongInt&&) const &;
+    LongInt   operator*(LongInt&&) &&;
 
     LongInt & operator/=(const LongInt&);
-    LongInt   operator/(const LongInt&) const;
+    LongInt   operator/(const LongInt&) const &;
+    LongInt   operator/(const LongInt&) &&;
 
     LongInt & operator%=(const LongInt&);
-    LongInt   operator%(const LongInt&) const;
+    LongInt   operator%(const LongInt&) const &;
+    LongInt   operator%(const LongInt&) &&;
+
+    //Shifts by a number of bits. A negative count shifts the
+    //other way. >> rounds toward negative infinity, the same as
+    //shifting a two's complement number.
+    LongInt & operator<<=(const int);
+    LongInt   operator<<(const int) const;
+    LongInt & operator>>=(const int);
+    LongInt   operator>>(const int) const;
+
+    //Bitwise operators treat negative numbers as two's complement
+    //with infinitely many leading ones, so ~x = -x - 1.
+    LongInt & operator&=(const LongInt&);
+    LongInt   operator&(const LongInt&) const;
+    LongInt & operator|=(const LongInt&);
+    LongInt   operator|(const LongInt&) const;
+    LongInt & operator^=(const LongInt&);
+    LongInt   operator^(const LongInt&) const;
+    LongInt   operator~() const;
+
+    //Quotient and remainder from a single division. Same
+    //rounding as / and %, so the remainder takes the sign of
+    //this LongInt. Either result may be this LongInt.
+    void divmod(const LongInt&, LongInt&, LongInt&) const;
+
+    //*this = a * b + c_sign * c. When the product and c have the
+    //same sign the product is added straight into c's limbs
+    //instead of being built on its own first.
+    LongInt & assign_fma(const LongInt&, const LongInt&, const LongInt&,
+                         const int c_sign = 1);
+    //*this = a * b % m, same rounding as %, without keeping the
+    //product or quotient around.
+    LongInt & assign_mulmod(const LongInt&, const LongInt&, const LongInt&);
+
+    //*this = gcd(a, b), which is never negative. gcd(0, 0) = 0.
+    LongInt & assign_gcd(const LongInt&, const LongInt&);
+    //*this = g = gcd(a, b), along with s and t such that
+    //s * a + t * b = g and |s| <= |b| / (2g). s and t may be a
+    //or b.
+    LongInt & assign_gcdext(const LongInt&, const LongInt&,
+                            LongInt&, LongInt&);
+
+    //*this = the k-th root of a, rounded toward zero. Throws
+    //InvalidRootError for k < 1 or an even root of a negative.
+    LongInt & assign_root(const LongInt&, const int);
 
     //Absolute Value.
     LongInt abs() const;
 
+    //Number of one bits in the magnitude, and the number of bits
+    //needed to write it. Both are 0 for 0.
+    int popcount() const;
+    int bit_length() const;
+    //Bit i in two's complement, so a negative number has all its
+    //high bits set.
+    bool test_bit(const int) const;
+
     LongInt & multeq_tenpower(const int);
     LongInt & multeq_digit(const int);
 
+    //Checked conversions. All throw IntConversionOverflowError
+    //if the value doesn't fit, including a negative value for
+    //to_uint64.
     int int_val() const;
     explicit operator int() const;
+    std::int64_t to_int64() const;
+    std::uint64_t to_uint64() const;
+
+    //Text in base 10 or 16, with a leading '-' if negative.
+    std::string to_string(const int base = 10) const;
+
+    //Hash for hash tables. The first call hashes the limbs and
+    //later ones reuse that until the value changes, so looking up
+    //the same key again is O(1). The seed is picked at random once
+    //per process, which keeps crafted keys from all landing in one
+    //bucket, unless LONGINT_HASH_SEED is defined to fix it.
+    std::size_t hash() const;
+    //Hash with a given seed, the same in every run and on every
+    //machine. Not cached.
+    std::uint64_t hash(const std::uint64_t) const;
+
+    //Raw access to the magnitude, least significant limb first.
+    //Zero has no limbs.
+    inline
+    int limb_count() const { return x_.size(); }
+    inline
+    const limb_t * limbs() const { return x_.data(); }
+
+    friend std::ostream & operator<<(std::ostream&, const LongInt&);
+    friend class ModContext;
+    template<int> friend class FixedInt;
+    friend class LongIntView;
+    friend std::from_chars_result from_chars(const char*, const char*,
+                                             LongInt&, const int);
+    friend const char * deserialize(const char*, const char*, LongInt&);
 
 private:   
-    std::vector<int> x_;
+    LimbArr x_;
     int sign_;
+
+    //hash() of the magnitude, folded to fit the bytes after sign_,
+    //or 0 if not worked out yet. The sign is mixed in on the way
+    //out, since sign() can change it without touching the limbs.
+    mutable std::atomic<std::uint32_t> hash_ { 0 };
+
+    //Decimal digits worked out so far by size() and operator[],
+    //dropped whenever the value changes.
+    struct DigitCache;
+    mutable std::atomic<DigitCache *> dec_ { nullptr };
+
+    DigitCache & digit_cache() const;
+    void fill_digits(DigitCache&, const int) const;
+    int decimal_size() const;
+
+    //Drop the digit cache and the cached hash.
+    void forget_caches();
+
+    //Drop high zero limbs and make sure zero is positive. Every
+    //change to the limbs ends here, so it also drops the cached
+    //digits and hash.
+    void trim();
+
+    //*this += l, taking l's sign to be l_sign. Lets -= add
+    //without copying l to flip its sign.
+    LongInt & add_signed(const LongInt&, const int);
+
+    //*this = *this op l for op '&', '|' or '^'.
+    LongInt & bitwise(const LongInt&, const char);
+
+    //Decimal digits of the magnitude.
+    std::string digits() const;
+
+    //Set to i, which works for any integer type up to 64 bits.
+    void assign_int64(const std::int64_t);
+    void assign_uint64(const std::uint64_t);
+
+    //Sign of *this - i, as -1, 0 or 1.
+    int compare_int64(const std::int64_t) const;
+    int compare_uint64(const std::uint64_t) const;
+
+    template<class T>
+    int compare_int(const T i) const
+    {
+        if (std::is_signed<T>::value)
+            return compare_int64(static_cast<std::int64_t>(i));
+
+        return compare_uint64(static_cast<std::uint64_t>(i));
+    }
 };
 
-bool operator==(const int, const LongInt&);
-bool operator!=(const int, const LongInt&);
-bool operator> (const int, const LongInt&);
-bool operator>=(const int, const LongInt&);
-bool operator< (const int, const LongInt&);
-bool operator<=(const int, const LongInt&);
+template<class T>
+typename std::enable_if<is_machine_int<T>::value, bool>::type
+operator==(const T i, const LongInt & l) { return l == i; }
+template<class T>
+typename std::enable_if<is_machine_int<T>::value, bool>::type
+operator!=(const T i, const LongInt & l) { return l != i; }
+template<class T>
+typename std::enable_if<is_machine_int<T>::value, bool>::type
+operator> (const T i, const LongInt & l) { return l < i; }
+template<class T>
+typename std::enable_if<is_machine_int<T>::value, bool>::type
+operator>=(const T i, const LongInt & l) { return l <= i; }
+template<class T>
+typename std::enable_if<is_machine_int<T>::value, bool>::type
+operator< (const T i, const LongInt & l) { return l > i; }
+template<class T>
+typename std::enable_if<is_machine_int<T>::value, bool>::type
+operator<=(const T i, const LongInt & l) { return l >= i; }
 
 LongInt operator+(const int, const LongInt&);
 LongInt operator-(const int, const LongInt&);
@@ -97,9 +323,195 @@ int & operator%=(int &, const LongInt&);
 
 LongInt abs(const LongInt &);
 
+//a * b + c and a * b % m through the fused kernels above.
+LongInt fma(const LongInt&, const LongInt&, const LongInt&);
+LongInt mulmod(const LongInt&, const LongInt&, const LongInt&);
+
+//gcd(a, b), and the extended form returning g with s and t as
+//in assign_gcdext.
+LongInt gcd(const LongInt&, const LongInt&);
+LongInt gcdext(const LongInt&, const LongInt&, LongInt&, LongInt&);
+
+//x with a * x = 1 mod |m| and 0 <= x < |m|. Throws
+//NotInvertibleError if gcd(a, m) is not 1.
+LongInt modinv(const LongInt&, const LongInt&);
+
+//Roots rounded toward zero, see assign_root.
+LongInt isqrt(const LongInt&);
+LongInt iroot(const LongInt&, const int);
+
+//Whether a = b^2, or a = b^k for some k >= 2. 0, 1 and -1 count as
+//perfect powers and negative numbers as odd ones.
+bool is_perfect_square(const LongInt&);
+bool is_perfect_power(const LongInt&);
+
+//base^exp by repeated squaring. Throws NegativeExponentError if
+//exp is negative. See ModContext.h for powmod.
+LongInt pow(const LongInt&, const int);
+
+//Products by balanced trees: neighbours are multiplied in pairs,
+//then the pairs in pairs and so on, so the operands stay about the
+//same size and fast multiplication does most of the work.
+//n! throws NegativeArgumentError for negative n. binomial(n, k) is
+//0 for k < 0 and follows C(n, k) = (-1)^k C(k - n - 1, k) for
+//negative n. primorial(n) is the product of the primes up to n.
+LongInt factorial(const int);
+LongInt binomial(const LongInt&, const int);
+LongInt primorial(const int);
+
+//The product of every LongInt in v, which is used as scratch.
+LongInt product_tree(std::vector<LongInt>&);
+
+//Product and sum of a range of LongInts, or of anything that
+//converts to one. An empty product is 1 and an empty sum 0.
+template<class It>
+LongInt product(It first, It last)
+{
+    std::vector<LongInt> v(first, last);
+    return product_tree(v);
+}
+
+template<class Range>
+LongInt product(const Range & r)
+{
+    return product(std::begin(r), std::end(r));
+}
+
+//Additions cost the length of the running total either way, so
+//the sum is accumulated in place rather than by a tree.
+template<class It>
+LongInt sum(It first, It last)
+{
+    LongInt ret;
+    for (; first != last; ++first)
+        ret += *first;
+
+    return ret;
+}
+
+template<class Range>
+LongInt sum(const Range & r)
+{
+    return sum(std::begin(r), std::end(r));
+}
+
 std::ostream & operator<<(std::ostream&, const LongInt&);
 
+//Same contract as std::to_chars / std::from_chars, for base 10 or
+//16: no '\0' is written, an optional '-' then at least one digit is
+//read, and any other base is an invalid_argument.
+std::to_chars_result to_chars(char*, char*, const LongInt&,
+                              const int base = 10);
+std::from_chars_result from_chars(const char*, const char*, LongInt&,
+                                  const int base = 10);
+
+namespace std
+{
+    template<>
+    struct hash<LongInt>
+    {
+        std::size_t operator()(const LongInt & l) const { return l.hash(); }
+    };
+}
+
 class DivideByZeroError{};
 class IntConversionOverflowError{};
+class InvalidBaseError{};
+class NegativeExponentError{};
+class NotInvertibleError{};
+class InvalidRootError{};
+class NegativeArgumentError{};
+
+
+/*
+  Literals: 123456789012345678901234567890_li, also in hex (0x),
+  octal (leading 0) or binary (0b), with ' separators allowed. The
+  digits are converted to limbs by the compiler, so making the
+  LongInt only copies the finished limbs, and a value of up to
+  LimbArr's inline size doesn't even allocate. A digit that doesn't
+  belong to the base is a compile error.
+
+  LongInt itself keeps its limbs on the heap once they outgrow the
+  inline buffer, which a constant expression can't do. FixedInt is
+  the type for arithmetic at compile time.
+*/
+template<char... C>
+class LongIntLiteral
+{
+    static constexpr char text_[] = { C... };
+    static constexpr int len_ = sizeof(text_);
+
+    static constexpr int base()
+    {
+        if (len_ > 1 && text_[0] == '0')
+        {
+            if (text_[1] == 'x' || text_[1] == 'X')
+                return 16;
+            if (text_[1] == 'b' || text_[1] == 'B')
+                return 2;
+
+            return 8;
+        }
+
+        return 10;
+    }
+
+    static constexpr int digit(const char c)
+    {
+        int d = (c >= '0' && c <= '9' ? c - '0' :
+                 c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                 c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16);
+        if (d >= base())
+            throw InvalidBaseError();
+
+        return d;
+    }
+
+public:
+    //No digit takes more than 4 bits.
+    static const int CAPACITY = len_ * 4 / LIMB_BITS + 1;
+
+    struct Limbs
+    {
+        limb_t x[CAPACITY];
+        int n;
+    };
+
+    //x = x * base + digit for each digit, then drop high zeros.
+    static constexpr Limbs convert()
+    {
+        Limbs r = {};
+        const int b = base();
+        for (int i = (b == 16 || b == 2 ? 2 : 0); i < len_; i++)
+        {
+            if (text_[i] == '\'')
+                continue;
+
+            dlimb_t carry = digit(text_[i]);
+            for (int j = 0; j < CAPACITY; j++)
+            {
+                carry += static_cast<dlimb_t>(r.x[j]) * b;
+                r.x[j] = static_cast<limb_t>(carry);
+                carry >>= LIMB_BITS;
+            }
+        }
+
+        r.n = CAPACITY;
+        while (r.n > 0 && r.x[r.n - 1] == 0)
+            r.n--;
+
+        return r;
+    }
+
+    static constexpr Limbs value = convert();
+};
+
+template<char... C>
+inline
+LongInt operator""_li()
+{
+    typedef LongIntLiteral<C...> L;
+    return LongInt(L::value.x, L::value.n);
+}
 
 #endif
@@ -0,0 +1,592 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongIntBench.cpp
+
+/*
+  Microbenchmarks for LongInt over a sweep of operand sizes, from 1
+  to 10^6 decimal digits in steps of about sqrt(10). The results go
+  out as JSON, one measurement per line, so two runs can be diffed
+  directly, or compared with --baseline, when tuning the
+  limb_thresholds cutoffs or checking a change for regressions.
+
+  Usage: longint_bench [options]
+      --max-digits N   largest operand size, default 1000000
+      --min-time S     seconds spent on each measurement, default 0.2
+      --ops a,b,...    only run these operations
+      --set name=N     set a limb_thresholds field, e.g. toom3=300
+      --threads N      threads per multiplication, limbs_set_threads
+      --out FILE       write the JSON to FILE instead of stdout
+      --baseline FILE  compare with an earlier run's JSON and report
+                       every result slower by more than --tolerance
+      --tolerance F    allowed slowdown for --baseline, default 0.10
+
+  Times are nanoseconds per operation, the best of several batches.
+  The exit status is 1 when --baseline finds a regression and 2 for
+  bad arguments.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LongInt.h"
+#include "ModContext.h"
+
+namespace
+{
+    const int FORMAT_VERSION = 1;
+    const int BATCHES = 5;
+    //Runs taking longer than this are timed twice rather than
+    //BATCHES times, so the top of the sweep finishes in minutes.
+    const double LONG_RUN = 1.0;
+
+    //The operands for one size. a and b have the size in digits,
+    //wide has twice that, so / and % get a full length quotient,
+    //m is an odd modulus of the size and unit is invertible mod m.
+    //The product trees take an int, picked so their result has
+    //about the size in digits: n! for fact_n, binomial(2n, n) for
+    //binom_n and the primorial of prim_n.
+    struct Operands
+    {
+        LongInt a, b, wide, m, unit;
+        std::string text;
+        int fact_n, binom_n, prim_n;
+    };
+
+    //One operation. max_digits keeps the slow ones, like powmod,
+    //from taking all day at the top of the sweep. The result goes
+    //to sink so the work can't be optimized away.
+    struct BenchOp
+    {
+        const char * name;
+        int max_digits;
+        void (*run)(const Operands&, LongInt&);
+    };
+
+    void run_add(const Operands & o, LongInt & r)
+    {
+        r = o.a + o.b;
+        return;
+    }
+
+    void run_sub(const Operands & o, LongInt & r)
+    {
+        r = o.a - o.b;
+        return;
+    }
+
+    void run_mul(const Operands & o, LongInt & r)
+    {
+        r = o.a * o.b;
+        return;
+    }
+
+    void run_sqr(const Operands & o, LongInt & r)
+    {
+        r = o.a * o.a;
+        return;
+    }
+
+    void run_div(const Operands & o, LongInt & r)
+    {
+        r = o.wide / o.b;
+        return;
+    }
+
+    void run_mod(const Operands & o, LongInt & r)
+    {
+        r = o.wide % o.b;
+        return;
+    }
+
+    void run_parse(const Operands & o, LongInt & r)
+    {
+        r = o.text.c_str();
+        return;
+    }
+
+    void run_print(const Operands & o, LongInt & r)
+    {
+        r = int(o.a.to_string().size());
+        return;
+    }
+
+    void run_shl(const Operands & o, LongInt & r)
+    {
+        r = o.a << 37;
+        return;
+    }
+
+    void run_shr(const Operands & o, LongInt & r)
+    {
+        r = o.a >> 37;
+        return;
+    }
+
+    void run_and(const Operands & o, LongInt & r)
+    {
+        r = o.a & o.b;
+        return;
+    }
+
+    void run_or(const Operands & o, LongInt & r)
+    {
+        r = o.a | o.b;
+        return;
+    }
+
+    void run_xor(const Operands & o, LongInt & r)
+    {
+        r = o.a ^ o.b;
+        return;
+    }
+
+    void run_fma(const Operands & o, LongInt & r)
+    {
+        r = fma(o.a, o.b, o.wide);
+        return;
+    }
+
+    void run_mulmod(const Operands & o, LongInt & r)
+    {
+        r = mulmod(o.a, o.b, o.m);
+        return;
+    }
+
+    void run_gcd(const Operands & o, LongInt & r)
+    {
+        r = gcd(o.a, o.b);
+        return;
+    }
+
+    void run_isqrt(const Operands & o, LongInt & r)
+    {
+        r = isqrt(o.wide);
+        return;
+    }
+
+    //m is odd and almost surely not a power, so every exponent
+    //gets tried.
+    void run_perfpow(const Operands & o, LongInt & r)
+    {
+        r = int(is_perfect_power(o.m));
+        return;
+    }
+
+    void run_modinv(const Operands & o, LongInt & r)
+    {
+        r = modinv(o.unit, o.m);
+        return;
+    }
+
+    void run_powmod(const Operands & o, LongInt & r)
+    {
+        r = powmod(o.a, o.b, o.m);
+        return;
+    }
+
+    void run_factorial(const Operands & o, LongInt & r)
+    {
+        r = factorial(o.fact_n);
+        return;
+    }
+
+    void run_binomial(const Operands & o, LongInt & r)
+    {
+        r = binomial(2 * o.binom_n, o.binom_n);
+        return;
+    }
+
+    void run_primorial(const Operands & o, LongInt & r)
+    {
+        r = primorial(o.prim_n);
+        return;
+    }
+
+    const BenchOp OPS[] =
+    {
+        { "add",       1000000, run_add },
+        { "sub",       1000000, run_sub },
+        { "mul",       1000000, run_mul },
+        { "sqr",       1000000, run_sqr },
+        { "div",       1000000, run_div },
+        { "mod",       1000000, run_mod },
+        { "shl",       1000000, run_shl },
+        { "shr",       1000000, run_shr },
+        { "and",       1000000, run_and },
+        { "or",        1000000, run_or },
+        { "xor",       1000000, run_xor },
+        { "fma",       1000000, run_fma },
+        { "mulmod",    1000000, run_mulmod },
+        { "parse",     1000000, run_parse },
+        { "print",     1000000, run_print },
+        { "gcd",       1000000, run_gcd },
+        { "isqrt",     1000000, run_isqrt },
+        { "perfpow",   1000000, run_perfpow },
+        { "modinv",     100000, run_modinv },
+        { "powmod",       1000, run_powmod },
+        { "factorial", 1000000, run_factorial },
+        { "binomial",   300000, run_binomial },
+        { "primorial", 1000000, run_primorial },
+    };
+
+    const int OP_COUNT = sizeof(OPS) / sizeof(OPS[0]);
+
+    //The limb_thresholds fields by name, for --set and the JSON.
+    const std::pair<const char *, int LimbThresholds::*> THRESHOLDS[] =
+    {
+        { "karatsuba", &LimbThresholds::karatsuba },
+        { "toom3",     &LimbThresholds::toom3 },
+        { "ntt",       &LimbThresholds::ntt },
+        { "div_dc",    &LimbThresholds::div_dc },
+        { "radix_dc",  &LimbThresholds::radix_dc },
+        { "redc",      &LimbThresholds::redc },
+        { "gcd_dc",    &LimbThresholds::gcd_dc },
+        { "hgcd",      &LimbThresholds::hgcd },
+        { "parallel",  &LimbThresholds::parallel },
+    };
+
+    struct Options
+    {
+        int max_digits = 1000000;
+        double min_time = 0.2;
+        std::vector<std::string> ops;
+        int threads = 1;
+        std::string out;
+        std::string baseline;
+        double tolerance = 0.10;
+    };
+
+    struct Result
+    {
+        std::string op;
+        int digits;
+        double ns;
+        long long reps;
+    };
+
+    //1, 3, 10, 30, 100, ... up to max.
+    std::vector<int> sweep(const int max)
+    {
+        std::vector<int> ret;
+        for (long long p = 1; p <= max; p *= 10)
+        {
+            ret.push_back(p);
+            if (3 * p <= max)
+                ret.push_back(3 * p);
+        }
+
+        return ret;
+    }
+
+    //n random digits without a leading zero.
+    std::string random_digits(const int n, std::mt19937 & gen)
+    {
+        std::string ret(n, '0');
+        for (int i = 0; i < n; i++)
+            ret[i] = '0' + gen() % 10;
+        ret[0] = '1' + gen() % 9;
+
+        return ret;
+    }
+
+    //Seeded by the size, so every run times the same operands.
+    Operands make_operands(const int digits)
+    {
+        std::mt19937 gen(digits);
+        Operands o;
+        o.text = random_digits(digits, gen);
+        o.a = o.text.c_str();
+        o.b = random_digits(digits, gen).c_str();
+        o.wide = random_digits(2 * digits, gen).c_str();
+        o.m = random_digits(digits, gen).c_str();
+        if (o.m % 2 == 0)
+            o.m += 1;
+        o.unit = o.a;
+        while (gcd(o.unit, o.m) != 1)
+            o.unit += 1;
+
+        //log10(n!) grows a term at a time, binomial(2n, n) has
+        //about 2n log10(2) digits and the primorial of n about
+        //n / ln(10).
+        double fact_digits = 0;
+        o.fact_n = 1;
+        while (fact_digits < digits)
+            fact_digits += std::log10(double(++o.fact_n));
+        o.binom_n = std::max(1, int(digits / 0.60206));
+        o.prim_n = std::max(2, int(digits * 2.302585));
+
+        return o;
+    }
+
+    //Seconds to run op reps times.
+    double time_batch(const BenchOp & op, const Operands & o,
+                      const long long reps)
+    {
+        typedef std::chrono::steady_clock clock;
+        LongInt sink;
+
+        clock::time_point start = clock::now();
+        for (long long i = 0; i < reps; i++)
+            op.run(o, sink);
+
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    //Best time per run of op over BATCHES batches, each long enough
+    //to take about min_time / BATCHES.
+    Result measure(const BenchOp & op, const Operands & o,
+                   const int digits, const double min_time)
+    {
+        //Double the batch until it's long enough to time.
+        long long reps = 1;
+        double best = 0;
+        for (;;)
+        {
+            best = time_batch(op, o, reps);
+
+            if (best >= min_time / BATCHES || reps >= (1LL << 40))
+                break;
+            reps *= 2;
+        }
+
+        const int batches = (best / reps > LONG_RUN ? 2 : BATCHES);
+        for (int b = 1; b < batches; b++)
+            best = std::min(best, time_batch(op, o, reps));
+
+        Result ret;
+        ret.op = op.name;
+        ret.digits = digits;
+        ret.ns = best * 1e9 / reps;
+        ret.reps = reps;
+
+        return ret;
+    }
+
+    void write_json(std::ostream & out, const Options & opt,
+                    const std::vector<Result> & results)
+    {
+        out << "{\n";
+        out << "  \"format\": " << FORMAT_VERSION << ",\n";
+        out << "  \"threads\": " << opt.threads << ",\n";
+        out << "  \"min_time\": " << opt.min_time << ",\n";
+        out << "  \"thresholds\": {";
+        for (const auto & t : THRESHOLDS)
+        {
+            out << (t.first == THRESHOLDS[0].first ? " " : ", ") << '"'
+                << t.first << "\": " << limb_thresholds.*t.second;
+        }
+        out << " },\n";
+        out << "  \"results\": [\n";
+        for (int i = 0; i < int(results.size()); i++)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line),
+                          "    { \"op\": \"%s\", \"digits\": %d, \"ns\": %.1f,"
+                          " \"reps\": %lld }%s\n",
+                          results[i].op.c_str(), results[i].digits,
+                          results[i].ns, results[i].reps,
+                          i + 1 < int(results.size()) ? "," : "");
+            out << line;
+        }
+        out << "  ]\n";
+        out << "}\n";
+
+        return;
+    }
+
+    //The results of an earlier run by (op, digits). Only reads the
+    //one result per line layout write_json produces.
+    bool read_baseline(const std::string & file,
+                       std::map<std::pair<std::string, int>, double> & base)
+    {
+        std::ifstream in(file);
+        if (!in)
+            return false;
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            char op[32];
+            int digits = 0;
+            double ns = 0;
+            if (std::sscanf(line.c_str(), " { \"op\": \"%31[^\"]\","
+                            " \"digits\": %d, \"ns\": %lf",
+                            op, &digits, &ns) == 3)
+                base[std::make_pair(std::string(op), digits)] = ns;
+        }
+
+        return true;
+    }
+
+    void usage()
+    {
+        std::cerr << "usage: longint_bench [--max-digits N] [--min-time S]"
+                  << " [--ops a,b,...] [--set name=N] [--threads N]"
+                  << " [--out FILE] [--baseline FILE] [--tolerance F]\n"
+                  << "operations:";
+        for (int i = 0; i < OP_COUNT; i++)
+            std::cerr << ' ' << OPS[i].name;
+        std::cerr << "\nthresholds:";
+        for (const auto & t : THRESHOLDS)
+            std::cerr << ' ' << t.first;
+        std::cerr << '\n';
+
+        return;
+    }
+
+    bool set_threshold(const std::string & arg)
+    {
+        std::string::size_type eq = arg.find('=');
+        if (eq == std::string::npos)
+            return false;
+
+        for (const auto & t : THRESHOLDS)
+        {
+            if (arg.compare(0, eq, t.first) == 0 && std::strlen(t.first) == eq)
+            {
+                limb_thresholds.*t.second = std::atoi(arg.c_str() + eq + 1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool parse_args(const int argc, char * argv[], Options & opt)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (i + 1 == argc)
+                return false;
+            std::string val = argv[++i];
+
+            if (arg == "--max-digits")
+                opt.max_digits = std::atoi(val.c_str());
+            else if (arg == "--min-time")
+                opt.min_time = std::atof(val.c_str());
+            else if (arg == "--threads")
+                opt.threads = std::atoi(val.c_str());
+            else if (arg == "--out")
+                opt.out = val;
+            else if (arg == "--baseline")
+                opt.baseline = val;
+            else if (arg == "--tolerance")
+                opt.tolerance = std::atof(val.c_str());
+            else if (arg == "--set")
+            {
+                if (!set_threshold(val))
+                    return false;
+            }
+            else if (arg == "--ops")
+            {
+                std::stringstream ss(val);
+                std::string name;
+                while (std::getline(ss, name, ','))
+                {
+                    bool found = false;
+                    for (int j = 0; j < OP_COUNT; j++)
+                        found = found || name == OPS[j].name;
+                    if (!found)
+                        return false;
+                    opt.ops.push_back(name);
+                }
+            }
+            else
+                return false;
+        }
+
+        return opt.max_digits >= 1 && opt.min_time > 0 && opt.threads >= 1;
+    }
+
+    bool selected(const Options & opt, const BenchOp & op)
+    {
+        if (opt.ops.empty())
+            return true;
+
+        for (const std::string & name : opt.ops)
+        {
+            if (name == op.name)
+                return true;
+        }
+
+        return false;
+    }
+}
+
+
+int main(int argc, char * argv[])
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt))
+    {
+        usage();
+        return 2;
+    }
+
+    std::map<std::pair<std::string, int>, double> base;
+    if (!opt.baseline.empty() && !read_baseline(opt.baseline, base))
+    {
+        std::cerr << "longint_bench: can't read " << opt.baseline << '\n';
+        return 2;
+    }
+
+    limbs_set_threads(opt.threads);
+
+    //Size by size, so each size's operands are built once.
+    std::vector<Result> results;
+    for (int digits : sweep(opt.max_digits))
+    {
+        Operands o = make_operands(digits);
+        for (int i = 0; i < OP_COUNT; i++)
+        {
+            if (selected(opt, OPS[i]) && digits <= OPS[i].max_digits)
+            {
+                results.push_back(measure(OPS[i], o, digits, opt.min_time));
+                std::cerr << OPS[i].name << ' ' << digits << ": "
+                          << results.back().ns << " ns\n";
+            }
+        }
+    }
+
+    if (opt.out.empty())
+        write_json(std::cout, opt, results);
+    else
+    {
+        std::ofstream out(opt.out);
+        write_json(out, opt, results);
+        if (!out)
+        {
+            std::cerr << "longint_bench: can't write " << opt.out << '\n';
+            return 2;
+        }
+    }
+
+    //Anything slower than the baseline by more than the tolerance.
+    int regressions = 0;
+    for (const Result & r : results)
+    {
+        auto it = base.find(std::make_pair(r.op, r.digits));
+        if (it != base.end() && r.ns > it->second * (1 + opt.tolerance))
+        {
+            std::cerr << "regression: " << r.op << ' ' << r.digits
+                      << " digits, " << it->second << " -> " << r.ns
+                      << " ns (+" << (r.ns / it->second - 1) * 100 << "%)\n";
+            regressions++;
+        }
+    }
+
+    return (regressions > 0 ? 1 : 0);
+}
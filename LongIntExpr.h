@@ -0,0 +1,285 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongIntExpr.h
+
+/*
+  Opt in lazy evaluation for LongInt expressions. Wrap one operand
+  in lazy() and the whole expression builds a small tree of nodes
+  instead of LongInt temporaries. Nothing is computed until the tree
+  is assigned or converted to a LongInt:
+
+      LongInt r = lazy(a) * b + c;   //one fused multiply-add
+      x = lazy(x) * y % m;           //modular multiply
+
+  When the tree is evaluated these shapes go to a fused kernel:
+      a * b + c, c + a * b, a * b - c, c - a * b   -> assign_fma
+      a * b % m                                    -> assign_mulmod
+  Anything else is evaluated the usual way, with intermediate
+  results reused through the rvalue operator overloads.
+
+  The kernels read every operand before writing their result, so
+  the target may appear on the right hand side. Nodes refer to the
+  LongInts they were built from, so evaluate an expression in the
+  same statement it is written in rather than holding it in an
+  auto variable.
+*/
+
+#ifndef LONG_INT_EXPR_H
+#define LONG_INT_EXPR_H
+
+#include <type_traits>
+#include <utility>
+
+#include "LongInt.h"
+
+//Leaf node, one LongInt operand.
+struct LongIntLazy
+{
+    const LongInt & x;
+
+    const LongInt & eval() const { return x; }
+};
+
+//Start a lazy expression.
+inline
+LongIntLazy lazy(const LongInt & x) { return LongIntLazy{ x }; }
+
+//Operator tags.
+struct LongIntAdd
+{
+    template<class X, class Y>
+    static LongInt apply(X && x, Y && y)
+    {
+        return std::forward<X>(x) + std::forward<Y>(y);
+    }
+};
+
+struct LongIntSub
+{
+    template<class X, class Y>
+    static LongInt apply(X && x, Y && y)
+    {
+        return std::forward<X>(x) - std::forward<Y>(y);
+    }
+};
+
+struct LongIntMul
+{
+    template<class X, class Y>
+    static LongInt apply(X && x, Y && y)
+    {
+        return std::forward<X>(x) * std::forward<Y>(y);
+    }
+};
+
+struct LongIntDiv
+{
+    template<class X, class Y>
+    static LongInt apply(X && x, Y && y)
+    {
+        return std::forward<X>(x) / std::forward<Y>(y);
+    }
+};
+
+struct LongIntMod
+{
+    template<class X, class Y>
+    static LongInt apply(X && x, Y && y)
+    {
+        return std::forward<X>(x) % std::forward<Y>(y);
+    }
+};
+
+
+template<class Op, class A, class B>
+struct LongIntEval;
+
+//Interior node, Op applied to two sub expressions.
+template<class Op, class A, class B>
+struct LongIntExpr
+{
+    A a;
+    B b;
+
+    LongInt eval() const { return LongIntEval<Op, A, B>::run(a, b); }
+
+    operator LongInt() const { return eval(); }
+};
+
+
+//Plain evaluation. A leaf evaluates to a reference and anything
+//else to a temporary, which the operator is free to reuse.
+template<class Op, class A, class B>
+struct LongIntEval
+{
+    static LongInt run(const A & a, const B & b)
+    {
+        auto && x = a.eval();
+        auto && y = b.eval();
+
+        return Op::apply(std::forward<decltype(x)>(x),
+                         std::forward<decltype(y)>(y));
+    }
+};
+
+
+//p.a * p.b + c_sign * c, negated after if negate is set.
+template<class A, class B, class C>
+LongInt longint_fma(const LongIntExpr<LongIntMul, A, B> & p, const C & c,
+                    const int c_sign, const bool negate = false)
+{
+    auto && x = p.a.eval();
+    auto && y = p.b.eval();
+    auto && z = c.eval();
+
+    LongInt ret;
+    ret.assign_fma(x, y, z, c_sign);
+    if (negate && ret != 0)
+        ret.sign() *= -1;
+
+    return ret;
+}
+
+//a * b + c
+template<class A, class B, class C>
+struct LongIntEval<LongIntAdd, LongIntExpr<LongIntMul, A, B>, C>
+{
+    static LongInt run(const LongIntExpr<LongIntMul, A, B> & p, const C & c)
+    {
+        return longint_fma(p, c, 1);
+    }
+};
+
+//c + a * b
+template<class A, class B, class C>
+struct LongIntEval<LongIntAdd, C, LongIntExpr<LongIntMul, A, B> >
+{
+    static LongInt run(const C & c, const LongIntExpr<LongIntMul, A, B> & p)
+    {
+        return longint_fma(p, c, 1);
+    }
+};
+
+//a * b + c * d, fuse the first product.
+template<class A, class B, class C, class D>
+struct LongIntEval<LongIntAdd, LongIntExpr<LongIntMul, A, B>,
+                   LongIntExpr<LongIntMul, C, D> >
+{
+    static LongInt run(const LongIntExpr<LongIntMul, A, B> & p,
+                       const LongIntExpr<LongIntMul, C, D> & c)
+    {
+        return longint_fma(p, c, 1);
+    }
+};
+
+//a * b - c
+template<class A, class B, class C>
+struct LongIntEval<LongIntSub, LongIntExpr<LongIntMul, A, B>, C>
+{
+    static LongInt run(const LongIntExpr<LongIntMul, A, B> & p, const C & c)
+    {
+        return longint_fma(p, c, -1);
+    }
+};
+
+//c - a * b = -(a * b - c)
+template<class A, class B, class C>
+struct LongIntEval<LongIntSub, C, LongIntExpr<LongIntMul, A, B> >
+{
+    static LongInt run(const C & c, const LongIntExpr<LongIntMul, A, B> & p)
+    {
+        return longint_fma(p, c, -1, true);
+    }
+};
+
+//a * b - c * d, fuse the first product.
+template<class A, class B, class C, class D>
+struct LongIntEval<LongIntSub, LongIntExpr<LongIntMul, A, B>,
+                   LongIntExpr<LongIntMul, C, D> >
+{
+    static LongInt run(const LongIntExpr<LongIntMul, A, B> & p,
+                       const LongIntExpr<LongIntMul, C, D> & c)
+    {
+        return longint_fma(p, c, -1);
+    }
+};
+
+//a * b % m
+template<class A, class B, class M>
+struct LongIntEval<LongIntMod, LongIntExpr<LongIntMul, A, B>, M>
+{
+    static LongInt run(const LongIntExpr<LongIntMul, A, B> & p, const M & m)
+    {
+        auto && x = p.a.eval();
+        auto && y = p.b.eval();
+        auto && z = m.eval();
+
+        LongInt ret;
+        ret.assign_mulmod(x, y, z);
+
+        return ret;
+    }
+};
+
+
+//Which types can be operands: LongInts and nodes.
+template<class T>
+struct is_longint_node : std::false_type {};
+template<>
+struct is_longint_node<LongIntLazy> : std::true_type {};
+template<class Op, class A, class B>
+struct is_longint_node<LongIntExpr<Op, A, B> > : std::true_type {};
+
+//A LongInt operand becomes a leaf, nodes stay as they are.
+template<class T>
+struct longint_node { typedef T type; };
+template<>
+struct longint_node<LongInt> { typedef LongIntLazy type; };
+
+inline
+LongIntLazy as_longint_node(const LongInt & x) { return LongIntLazy{ x }; }
+template<class E>
+const E & as_longint_node(const E & e) { return e; }
+
+//The node type for l Op r. Only exists when one side is already
+//a node, so plain LongInt expressions are not affected.
+template<class Op, class L, class R>
+using LongIntNodeFor = typename std::enable_if<
+    (is_longint_node<L>::value || is_longint_node<R>::value) &&
+    (is_longint_node<L>::value || std::is_same<L, LongInt>::value) &&
+    (is_longint_node<R>::value || std::is_same<R, LongInt>::value),
+    LongIntExpr<Op, typename longint_node<L>::type,
+                typename longint_node<R>::type> >::type;
+
+
+template<class L, class R>
+LongIntNodeFor<LongIntAdd, L, R> operator+(const L & l, const R & r)
+{
+    return { as_longint_node(l), as_longint_node(r) };
+}
+
+template<class L, class R>
+LongIntNodeFor<LongIntSub, L, R> operator-(const L & l, const R & r)
+{
+    return { as_longint_node(l), as_longint_node(r) };
+}
+
+template<class L, class R>
+LongIntNodeFor<LongIntMul, L, R> operator*(const L & l, const R & r)
+{
+    return { as_longint_node(l), as_longint_node(r) };
+}
+
+template<class L, class R>
+LongIntNodeFor<LongIntDiv, L, R> operator/(const L & l, const R & r)
+{
+    return { as_longint_node(l), as_longint_node(r) };
+}
+
+template<class L, class R>
+LongIntNodeFor<LongIntMod, L, R> operator%(const L & l, const R & r)
+{
+    return { as_longint_node(l), as_longint_node(r) };
+}
+
+#endif
@@ -0,0 +1,196 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongIntStats.cpp
+
+#include "LongIntStats.h"
+
+#include <atomic>
+
+namespace
+{
+    const char * const OP_NAMES[STAT_OPS] =
+    {
+        "copy", "add", "sub", "mul", "div", "mod", "divmod", "fma",
+        "mulmod", "shift", "bitwise", "gcd", "root", "pow", "powmod",
+        "parse", "print"
+    };
+
+    const char * const TIER_NAMES[STAT_TIERS] =
+    {
+        "mul_basecase", "mul_karatsuba", "mul_toom3", "mul_unbalanced",
+        "mul_ntt", "div_knuth", "div_bz", "radix_basecase", "radix_dc",
+        "gcd_lehmer", "gcd_hgcd", "mod_montgomery", "mod_barrett", "root"
+    };
+
+#ifdef LONGINT_STATS
+    //Relaxed atomics: every thread adds to the same counters, and
+    //nothing else is ordered by them.
+    std::atomic<long long> ops[STAT_OPS][STAT_BUCKETS];
+    std::atomic<long long> tier_calls[STAT_TIERS];
+    std::atomic<long long> tier_ns[STAT_TIERS];
+    std::atomic<long long> allocs, pool_hits, alloc_limbs, frees;
+
+    //The innermost running timer of this thread.
+    thread_local StatTimer * current = nullptr;
+
+    inline
+    void bump(std::atomic<long long> & c, const long long n = 1)
+    {
+        c.fetch_add(n, std::memory_order_relaxed);
+        return;
+    }
+
+    inline
+    long long read(const std::atomic<long long> & c)
+    {
+        return c.load(std::memory_order_relaxed);
+    }
+
+    inline
+    void clear(std::atomic<long long> & c)
+    {
+        c.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    int bucket(const int limbs)
+    {
+        int b = 0;
+        while (b < STAT_BUCKETS - 1 && (limbs >> b) != 0)
+            b++;
+
+        return b;
+    }
+#endif
+}
+
+
+LongIntStats longint_stats()
+{
+    LongIntStats s = {};
+
+#ifdef LONGINT_STATS
+    for (int i = 0; i < STAT_OPS; i++)
+        for (int b = 0; b < STAT_BUCKETS; b++)
+            s.ops[i][b] = read(ops[i][b]);
+
+    for (int t = 0; t < STAT_TIERS; t++)
+    {
+        s.tier_calls[t] = read(tier_calls[t]);
+        s.tier_ns[t] = read(tier_ns[t]);
+    }
+
+    s.allocs = read(allocs);
+    s.pool_hits = read(pool_hits);
+    s.alloc_limbs = read(alloc_limbs);
+    s.frees = read(frees);
+#endif
+
+    return s;
+}
+
+
+void longint_stats_reset()
+{
+#ifdef LONGINT_STATS
+    for (int i = 0; i < STAT_OPS; i++)
+        for (int b = 0; b < STAT_BUCKETS; b++)
+            clear(ops[i][b]);
+
+    for (int t = 0; t < STAT_TIERS; t++)
+    {
+        clear(tier_calls[t]);
+        clear(tier_ns[t]);
+    }
+
+    clear(allocs);
+    clear(pool_hits);
+    clear(alloc_limbs);
+    clear(frees);
+#endif
+
+    return;
+}
+
+
+const char * stat_op_name(const StatOp op)
+{
+    return (op >= 0 && op < STAT_OPS ? OP_NAMES[op] : "");
+}
+
+
+const char * stat_tier_name(const StatTier tier)
+{
+    return (tier >= 0 && tier < STAT_TIERS ? TIER_NAMES[tier] : "");
+}
+
+
+long long stat_bucket_limbs(const int b)
+{
+    return (b == 0 ? 0 : 1LL << (b - 1));
+}
+
+
+#ifdef LONGINT_STATS
+
+void stats_op(const StatOp op, const int limbs)
+{
+    bump(ops[op][bucket(limbs)]);
+    return;
+}
+
+
+void stats_alloc(const int limbs, const bool pooled)
+{
+    bump(allocs);
+    bump(alloc_limbs, limbs);
+    if (pooled)
+        bump(pool_hits);
+
+    return;
+}
+
+
+void stats_free()
+{
+    bump(frees);
+    return;
+}
+
+
+StatTimer::StatTimer(const StatTier tier) :
+    tier_(tier),
+    outer_(current),
+    start_(std::chrono::steady_clock::now())
+{
+    //Stop the outer tier's clock while this one runs.
+    if (outer_ != nullptr)
+    {
+        bump(tier_ns[outer_->tier_],
+             std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 start_ - outer_->start_).count());
+    }
+
+    current = this;
+
+    return;
+}
+
+
+StatTimer::~StatTimer()
+{
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    bump(tier_ns[tier_],
+         std::chrono::duration_cast<std::chrono::nanoseconds>(
+             now - start_).count());
+    bump(tier_calls[tier_]);
+
+    current = outer_;
+    if (outer_ != nullptr)
+        outer_->start_ = now;
+
+    return;
+}
+
+#endif
@@ -0,0 +1,158 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongIntStats.h
+
+/*
+  Optional counters for seeing where LongInt spends its time.
+  Building with LONGINT_STATS defined (cmake -DLONGINT_STATS=ON)
+  turns on:
+      - a count of each operation by the size of its larger
+        operand, in power of two buckets of limbs
+      - limb blocks allocated and freed, the limbs handed out, and
+        how many of the blocks came from the LimbPool. These count
+        every block that goes through limbs_alloc: LongInt storage
+        and the LimbVector scratch of the limb routines, NTT
+        included, even blocks too big for the pool to cache. The
+        char buffers of text conversion and the containers holding
+        LongInts are not counted, though any limbs those LongInts
+        allocate are.
+      - nanoseconds spent in each algorithm tier, such as Karatsuba
+        or Burnikel-Ziegler division. A tier's time only counts its
+        own work: when Karatsuba hands its sub products to the
+        basecase, that time goes to the basecase.
+
+  Without it every hook is an empty inline function and costs
+  nothing, and longint_stats() returns all zeros.
+
+  The counters are shared by all threads, so a snapshot covers the
+  whole process and tier times add up across threads. A snapshot
+  taken while other threads are working is not exact.
+
+  Operation counts can show call patterns that do more work than
+  they need to. Every division is counted as STAT_DIVMOD, on top of
+  STAT_DIV or STAT_MOD when it came from / or %, so matching DIV and
+  MOD counts in the same bucket often mean a / b next to a % b: two
+  divisions where one divmod would do.
+*/
+
+#ifndef LONG_INT_STATS_H
+#define LONG_INT_STATS_H
+
+#include <chrono>
+
+enum StatOp
+{
+    STAT_COPY,      //Copy construction and copy assignment.
+    STAT_ADD,
+    STAT_SUB,
+    STAT_MUL,
+    STAT_DIV,       // /, /=
+    STAT_MOD,       // %, %=
+    STAT_DIVMOD,    //Every division, from any of the above too.
+    STAT_FMA,
+    STAT_MULMOD,
+    STAT_SHIFT,
+    STAT_BITWISE,
+    STAT_GCD,
+    STAT_ROOT,
+    STAT_POW,
+    STAT_POWMOD,
+    STAT_PARSE,
+    STAT_PRINT,
+    STAT_OPS
+};
+
+enum StatTier
+{
+    TIER_MUL_BASECASE,
+    TIER_MUL_KARATSUBA,
+    TIER_MUL_TOOM3,
+    TIER_MUL_UNBALANCED,
+    TIER_MUL_NTT,
+    TIER_DIV_KNUTH,
+    TIER_DIV_BZ,
+    TIER_RADIX_BASECASE,
+    TIER_RADIX_DC,
+    TIER_GCD_LEHMER,
+    TIER_GCD_HGCD,
+    TIER_MOD_MONTGOMERY,
+    TIER_MOD_BARRETT,
+    TIER_ROOT,
+    STAT_TIERS
+};
+
+//Bucket b counts operands of 2^(b-1) to 2^b - 1 limbs, bucket 0 is
+//zero. The last bucket takes everything bigger.
+const int STAT_BUCKETS = 26;
+
+const bool LONGINT_STATS_ENABLED =
+#ifdef LONGINT_STATS
+    true;
+#else
+    false;
+#endif
+
+struct LongIntStats
+{
+    long long ops[STAT_OPS][STAT_BUCKETS];
+    long long tier_calls[STAT_TIERS];
+    long long tier_ns[STAT_TIERS];
+    long long allocs;       //Limb blocks handed out.
+    long long pool_hits;    //Of those, blocks from the LimbPool.
+    long long alloc_limbs;  //Limbs in the blocks handed out.
+    long long frees;
+};
+
+//A copy of the counters as they are now, and back to zero.
+LongIntStats longint_stats();
+void longint_stats_reset();
+
+//Names for scraping, like "mul" or "mul_karatsuba".
+const char * stat_op_name(const StatOp);
+const char * stat_tier_name(const StatTier);
+//First limb count in bucket b.
+long long stat_bucket_limbs(const int);
+
+//The hooks the library calls.
+#ifdef LONGINT_STATS
+
+void stats_op(const StatOp, const int);
+void stats_alloc(const int, const bool);
+void stats_free();
+
+//Charges the time from its construction to its destruction to a
+//tier, less the time of any tier timed inside it on the same
+//thread.
+class StatTimer
+{
+public:
+    explicit StatTimer(const StatTier);
+    ~StatTimer();
+
+    StatTimer(const StatTimer&) = delete;
+    StatTimer & operator=(const StatTimer&) = delete;
+
+private:
+    StatTier tier_;
+    StatTimer * outer_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#else
+
+inline
+void stats_op(const StatOp, const int) { return; }
+inline
+void stats_alloc(const int, const bool) { return; }
+inline
+void stats_free() { return; }
+
+class StatTimer
+{
+public:
+    explicit StatTimer(const StatTier) { return; }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,497 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongIntView.cpp
+
+#include "LongIntView.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const int LIMB_BYTES = LIMB_BITS / 8;
+
+    //Limbs are stored little endian, so on a little endian machine
+    //they go in and out with a plain copy.
+    inline
+    bool little_endian()
+    {
+        const limb_t one = 1;
+        return *reinterpret_cast<const unsigned char *>(&one) == 1;
+    }
+
+    //Limb count and sign folded into the number after the version.
+    inline
+    unsigned long long tag(const int n, const int sign)
+    {
+        return static_cast<unsigned long long>(n) * 2 + (sign == -1);
+    }
+
+    //Version, varint and padding.
+    int header_size(unsigned long long t)
+    {
+        int bytes = 2;
+        while (t >>= 7)
+            bytes++;
+
+        return (bytes + LIMB_BYTES - 1) / LIMB_BYTES * LIMB_BYTES;
+    }
+
+    //Writes the header for t, returns the end of it.
+    char * write_header(char * out, unsigned long long t)
+    {
+        char * p = out;
+        *p++ = LONGINT_FORMAT_VERSION;
+        do
+        {
+            unsigned char byte = t & 0x7F;
+            t >>= 7;
+            if (t != 0)
+                byte |= 0x80;
+            *p++ = byte;
+        } while (t != 0);
+
+        while ((p - out) % LIMB_BYTES != 0)
+            *p++ = 0;
+
+        return p;
+    }
+
+    //Reads the header at first, returns the start of the limbs.
+    //Checks that all n limbs are there and the top one is not
+    //zero.
+    const char * read_header(const char * first, const char * last,
+                             int & n, int & sign)
+    {
+        const char * p = first;
+        if (p == last || *p++ != LONGINT_FORMAT_VERSION)
+            throw InvalidEncodingError();
+
+        unsigned long long t = 0;
+        for (int shift = 0; ; shift += 7)
+        {
+            if (p == last || shift > 35)
+                throw InvalidEncodingError();
+
+            unsigned char byte = *p++;
+            t |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+
+        while ((p - first) % LIMB_BYTES != 0)
+        {
+            if (p == last)
+                throw InvalidEncodingError();
+            p++;
+        }
+
+        if (t / 2 > static_cast<unsigned long long>(INT_MAX / LIMB_BYTES) ||
+            static_cast<long long>(t / 2) * LIMB_BYTES > last - p)
+            throw InvalidEncodingError();
+
+        n = t / 2;
+        sign = (t & 1 ? -1 : 1);
+
+        //-0 and high zero limbs have other, shorter encodings.
+        if (n == 0 ? sign == -1 :
+            p[n * LIMB_BYTES - 1] == 0 && p[n * LIMB_BYTES - 2] == 0 &&
+            p[n * LIMB_BYTES - 3] == 0 && p[n * LIMB_BYTES - 4] == 0)
+            throw InvalidEncodingError();
+
+        return p;
+    }
+
+    void write_limbs(char * out, const limb_t * x, const int n)
+    {
+        if (little_endian())
+        {
+            std::memcpy(out, x, n * LIMB_BYTES);
+            return;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < LIMB_BYTES; j++)
+                *out++ = static_cast<char>(x[i] >> (8 * j));
+        }
+
+        return;
+    }
+
+    void read_limbs(limb_t * x, const char * in, const int n)
+    {
+        if (little_endian())
+        {
+            std::memcpy(x, in, n * LIMB_BYTES);
+            return;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            x[i] = 0;
+            for (int j = 0; j < LIMB_BYTES; j++)
+                x[i] |= static_cast<limb_t>(
+                    static_cast<unsigned char>(*in++)) << (8 * j);
+        }
+
+        return;
+    }
+}
+
+
+int serialized_size(const LongInt & l)
+{
+    return header_size(tag(l.limb_count(), l.sign())) +
+        l.limb_count() * LIMB_BYTES;
+}
+
+
+char * serialize(char * out, const LongInt & l)
+{
+    out = write_header(out, tag(l.limb_count(), l.sign()));
+    write_limbs(out, l.limbs(), l.limb_count());
+
+    return out + l.limb_count() * LIMB_BYTES;
+}
+
+
+std::ostream & serialize(std::ostream & out, const LongInt & l)
+{
+    char header[16];
+    out.write(header, write_header(header, tag(l.limb_count(), l.sign()))
+              - header);
+
+    if (little_endian())
+        out.write(reinterpret_cast<const char *>(l.limbs()),
+                  l.limb_count() * LIMB_BYTES);
+    else
+    {
+        std::vector<char> buf(l.limb_count() * LIMB_BYTES);
+        write_limbs(buf.data(), l.limbs(), l.limb_count());
+        out.write(buf.data(), buf.size());
+    }
+
+    return out;
+}
+
+
+const char * deserialize(const char * first, const char * last,
+                         LongInt & l)
+{
+    int n = 0, sign = 1;
+    const char * p = read_header(first, last, n, sign);
+
+    l.x_.resize(n);
+    read_limbs(l.x_.data(), p, n);
+    l.sign_ = sign;
+    l.trim();
+
+    return p + n * LIMB_BYTES;
+}
+
+
+std::istream & deserialize(std::istream & in, LongInt & l)
+{
+    //The header is read a byte at a time up to the end of the
+    //varint, then the padding and limbs in one go.
+    std::vector<char> buf;
+    char c = 0;
+    if (!in.get(c))
+        return in;
+    buf.push_back(c);
+
+    do
+    {
+        if (!in.get(c) || buf.size() > 8)
+        {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+        buf.push_back(c);
+    } while (c & 0x80);
+
+    unsigned long long t = 0;
+    for (int i = buf.size() - 1; i >= 1; i--)
+        t = (t << 7) | (buf[i] & 0x7F);
+
+    const int head = buf.size();
+    const unsigned long long total =
+        (head + LIMB_BYTES - 1) / LIMB_BYTES * LIMB_BYTES + t / 2 * LIMB_BYTES;
+    if (t / 2 > INT_MAX || total > INT_MAX)
+    {
+        in.setstate(std::ios::failbit);
+        return in;
+    }
+
+    buf.resize(total);
+    if (!in.read(buf.data() + head, total - head))
+        return in;
+
+    try
+    {
+        deserialize(buf.data(), buf.data() + buf.size(), l);
+    }
+    catch (InvalidEncodingError &)
+    {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+}
+
+
+LongIntView::LongIntView() :
+    x_(nullptr),
+    n_(0),
+    sign_(1),
+    header_(0)
+{
+    return;
+}
+
+
+LongIntView::LongIntView(const LongInt & l) :
+    x_(l.limbs()),
+    n_(l.limb_count()),
+    sign_(l.sign()),
+    header_(0)
+{
+    return;
+}
+
+
+LongIntView::LongIntView(const char * first, const char * last) :
+    x_(nullptr),
+    n_(0),
+    sign_(1),
+    header_(0)
+{
+    const char * p = read_header(first, last, n_, sign_);
+    if (!little_endian() ||
+        reinterpret_cast<std::uintptr_t>(p) % alignof(limb_t) != 0)
+        throw UnalignedBufferError();
+
+    x_ = reinterpret_cast<const limb_t *>(p);
+    header_ = p - first;
+
+    return;
+}
+
+
+int LongIntView::encoded_size() const
+{
+    return (header_ != 0 ? header_ : header_size(tag(n_, sign_))) +
+        n_ * LIMB_BYTES;
+}
+
+
+LongInt LongIntView::to_longint() const
+{
+    return LongInt(x_, n_, sign_);
+}
+
+
+LongIntView::operator LongInt() const
+{
+    return to_longint();
+}
+
+
+std::string LongIntView::to_string(const int base) const
+{
+    return to_longint().to_string(base);
+}
+
+
+void LongIntView::divmod(const LongIntView & l, LongInt & quotient,
+                         LongInt & remainder) const
+{
+    if (l.n_ == 0)
+        throw DivideByZeroError();
+
+    int q_sign = (sign_ != l.sign_ ? -1 : 1), r_sign = sign_;
+    LimbArr q, r;
+
+    if (limbs_cmp(x_, n_, l.x_, l.n_) < 0)
+        r.assign(x_, x_ + n_);
+
+    else
+    {
+        q.resize(n_ - l.n_ + 1);
+        r.resize(l.n_);
+        limbs_divrem(q.data(), r.data(), x_, n_, l.x_, l.n_);
+    }
+
+    //Everything is read, so the results may be under either view.
+    quotient.x_.swap(q);
+    quotient.sign_ = q_sign;
+    quotient.trim();
+
+    remainder.x_.swap(r);
+    remainder.sign_ = r_sign;
+    remainder.trim();
+
+    return;
+}
+
+
+LongInt LongIntView::add(const LongIntView & l, const int l_sign) const
+{
+    if (l.n_ == 0)
+        return to_longint();
+
+    const limb_t * a = x_, * b = l.x_;
+    int an = n_, bn = l.n_;
+    int a_sign = sign_, b_sign = l.sign_ * l_sign;
+    LongInt ret;
+
+    if (a_sign == b_sign)
+    {
+        if (an < bn)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+
+        ret.x_.resize(an + 1);
+        ret.x_[an] = limbs_add(ret.x_.data(), a, an, b, bn);
+        ret.sign_ = a_sign;
+    }
+
+    //Subtract the smaller magnitude from the bigger one, which
+    //decides the sign.
+    else
+    {
+        if (limbs_cmp(a, an, b, bn) < 0)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+            std::swap(a_sign, b_sign);
+        }
+
+        ret.x_.resize(an);
+        if (bn == 0)
+            std::copy(a, a + an, ret.x_.data());
+        else
+            limbs_sub(ret.x_.data(), a, an, b, bn);
+        ret.sign_ = a_sign;
+    }
+
+    ret.trim();
+
+    return ret;
+}
+
+
+LongInt LongIntView::mul(const LongIntView & l) const
+{
+    LongInt ret;
+    if (n_ == 0 || l.n_ == 0)
+        return ret;
+
+    ret.x_.resize(n_ + l.n_);
+    if (n_ >= l.n_)
+        limbs_mul(ret.x_.data(), x_, n_, l.x_, l.n_);
+    else
+        limbs_mul(ret.x_.data(), l.x_, l.n_, x_, n_);
+    ret.sign_ = (sign_ != l.sign_ ? -1 : 1);
+    ret.trim();
+
+    return ret;
+}
+
+
+bool operator==(const LongIntView & a, const LongIntView & b)
+{
+    return a.sign() == b.sign() &&
+        limbs_cmp(a.limbs(), a.limb_count(), b.limbs(), b.limb_count()) == 0;
+}
+
+
+bool operator!=(const LongIntView & a, const LongIntView & b)
+{
+    return !(a == b);
+}
+
+
+bool operator>(const LongIntView & a, const LongIntView & b)
+{
+    if (a.sign() != b.sign())
+        return a.sign() > b.sign();
+
+    return limbs_cmp(a.limbs(), a.limb_count(), b.limbs(), b.limb_count())
+        * a.sign() > 0;
+}
+
+
+bool operator>=(const LongIntView & a, const LongIntView & b)
+{
+    return !(b > a);
+}
+
+
+bool operator<(const LongIntView & a, const LongIntView & b)
+{
+    return b > a;
+}
+
+
+bool operator<=(const LongIntView & a, const LongIntView & b)
+{
+    return !(a > b);
+}
+
+
+LongInt operator+(const LongIntView & a, const LongIntView & b)
+{
+    return a.add(b, 1);
+}
+
+
+LongInt operator-(const LongIntView & a, const LongIntView & b)
+{
+    return a.add(b, -1);
+}
+
+
+LongInt operator*(const LongIntView & a, const LongIntView & b)
+{
+    return a.mul(b);
+}
+
+
+LongInt operator/(const LongIntView & a, const LongIntView & b)
+{
+    LongInt q, r;
+    a.divmod(b, q, r);
+
+    return q;
+}
+
+
+LongInt operator%(const LongIntView & a, const LongIntView & b)
+{
+    LongInt q, r;
+    a.divmod(b, q, r);
+
+    return r;
+}
+
+
+LongInt operator-(const LongIntView & a)
+{
+    LongInt ret = a.to_longint();
+    if (ret != 0)
+        ret.sign() *= -1;
+
+    return ret;
+}
+
+
+std::ostream & operator<<(std::ostream & out, const LongIntView & v)
+{
+    return out << v.to_longint();
+}
@@ -0,0 +1,130 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongIntView.h
+
+/*
+  Binary format for LongInts, and read only views that work on it
+  in place.
+
+  An encoded LongInt is, in order:
+      1 byte    format version, LONGINT_FORMAT_VERSION
+      varint    limb count * 2 + 1 if negative, 7 bits a byte, low
+                bits first, the top bit set on all but the last byte
+      0-3 bytes zeros, so the header is a multiple of 4 bytes
+      limbs     4 bytes each, least significant limb first, each
+                little endian
+  Zero is just its header. Every encoding is a multiple of 4 bytes
+  long, so encodings written one after the other into a 4 byte
+  aligned buffer all have aligned limbs.
+
+  That is what lets a LongIntView use the limbs where they lie,
+  such as in a memory mapped file, instead of copying them out:
+
+      const char * p = file_start;
+      while (p != file_end)
+      {
+          LongIntView v(p, file_end);
+          total += v * price;
+          p += v.encoded_size();
+      }
+
+  A LongInt converts to a view of its own limbs, so views and
+  LongInts mix freely in arithmetic. Results are LongInts. A view
+  is only good as long as the memory under it stays unchanged.
+*/
+
+#ifndef LONG_INT_VIEW_H
+#define LONG_INT_VIEW_H
+
+#include "LongInt.h"
+
+const int LONGINT_FORMAT_VERSION = 1;
+
+//Bytes needed to encode l.
+int serialized_size(const LongInt&);
+
+//Write l to out, which has room for serialized_size(l) bytes.
+//Returns the end of what was written.
+char * serialize(char*, const LongInt&);
+std::ostream & serialize(std::ostream&, const LongInt&);
+
+//Read one LongInt from [first, last) and return the end of it.
+//Throws InvalidEncodingError if it is cut short or the version is
+//not one this code knows.
+const char * deserialize(const char*, const char*, LongInt&);
+//Sets failbit instead of throwing.
+std::istream & deserialize(std::istream&, LongInt&);
+
+class LongIntView
+{
+public:
+    //Zero.
+    LongIntView();
+    //The limbs of l, in l.
+    LongIntView(const LongInt&);
+    //The LongInt encoded at the start of [first, last). Throws
+    //InvalidEncodingError like deserialize, and
+    //UnalignedBufferError if the limbs are not 4 byte aligned or
+    //this machine is not little endian, since then they can't be
+    //used in place.
+    LongIntView(const char*, const char*);
+
+    inline
+    int sign() const { return sign_; }
+    inline
+    int limb_count() const { return n_; }
+    inline
+    const limb_t * limbs() const { return x_; }
+
+    //Length of the encoding this view was made from, or of this
+    //value's encoding for a view of a LongInt.
+    int encoded_size() const;
+
+    LongInt to_longint() const;
+    explicit operator LongInt() const;
+
+    std::string to_string(const int base = 10) const;
+
+    //Same as LongInt::divmod. Either result may be the LongInt
+    //under either view.
+    void divmod(const LongIntView&, LongInt&, LongInt&) const;
+
+    friend LongInt operator+(const LongIntView&, const LongIntView&);
+    friend LongInt operator-(const LongIntView&, const LongIntView&);
+    friend LongInt operator*(const LongIntView&, const LongIntView&);
+
+private:
+    const limb_t * x_;
+    int n_;
+    int sign_;
+
+    //Bytes from the start of the encoding to the limbs, 0 for a
+    //view of a LongInt.
+    int header_;
+
+    //*this + l_sign * l, and *this * l.
+    LongInt add(const LongIntView&, const int) const;
+    LongInt mul(const LongIntView&) const;
+};
+
+bool operator==(const LongIntView&, const LongIntView&);
+bool operator!=(const LongIntView&, const LongIntView&);
+bool operator> (const LongIntView&, const LongIntView&);
+bool operator>=(const LongIntView&, const LongIntView&);
+bool operator< (const LongIntView&, const LongIntView&);
+bool operator<=(const LongIntView&, const LongIntView&);
+
+//Same rounding as LongInt. / and % throw DivideByZeroError.
+LongInt operator+(const LongIntView&, const LongIntView&);
+LongInt operator-(const LongIntView&, const LongIntView&);
+LongInt operator*(const LongIntView&, const LongIntView&);
+LongInt operator/(const LongIntView&, const LongIntView&);
+LongInt operator%(const LongIntView&, const LongIntView&);
+LongInt operator-(const LongIntView&);
+
+std::ostream & operator<<(std::ostream&, const LongIntView&);
+
+class InvalidEncodingError{};
+class UnalignedBufferError{};
+
+#endif
@@ -0,0 +1,356 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongRational.cpp
+
+#include "LongRational.h"
+
+#include <algorithm>
+#include <string>
+
+LongRational::LongRational() :
+    num_(0),
+    den_(1),
+    reduced_(true),
+    limit_(REDUCE_LIMBS)
+{
+    return;
+}
+
+
+LongRational::LongRational(const int n) :
+    num_(n),
+    den_(1),
+    reduced_(true),
+    limit_(REDUCE_LIMBS)
+{
+    return;
+}
+
+
+LongRational::LongRational(const LongInt & n) :
+    num_(n),
+    den_(1),
+    reduced_(true),
+    limit_(REDUCE_LIMBS)
+{
+    return;
+}
+
+
+LongRational::LongRational(const LongInt & n, const LongInt & d) :
+    num_(n),
+    den_(d),
+    reduced_(false),
+    limit_(REDUCE_LIMBS)
+{
+    if (den_ == 0)
+        throw DivideByZeroError();
+
+    if (den_.sign() == -1)
+    {
+        den_.sign() = 1;
+        if (num_ != 0)
+            num_.sign() *= -1;
+    }
+
+    reduced_ = (den_ == 1);
+    settle();
+
+    return;
+}
+
+
+LongRational::LongRational(const char s[]) :
+    LongRational()
+{
+    std::string text(s);
+    std::string::size_type slash = text.find('/');
+    if (slash == std::string::npos)
+        *this = LongRational(LongInt(s));
+    else
+        *this = LongRational(LongInt(text.substr(0, slash).c_str()),
+                             LongInt(text.substr(slash + 1).c_str()));
+
+    return;
+}
+
+
+const LongInt & LongRational::numerator() const
+{
+    normalize();
+    return num_;
+}
+
+
+const LongInt & LongRational::denominator() const
+{
+    normalize();
+    return den_;
+}
+
+
+void LongRational::normalize() const
+{
+    if (num_ == 0)
+        den_ = 1;
+
+    else if (!reduced_)
+    {
+        LongInt g = gcd(num_, den_);
+        if (g != 1)
+        {
+            num_ /= g;
+            den_ /= g;
+        }
+
+        reduced_ = true;
+    }
+
+    limit_ = std::max<int>(REDUCE_LIMBS, 2 * den_.limb_count());
+
+    return;
+}
+
+
+bool LongRational::operator==(const LongRational & r) const
+{
+    if (reduced_ && r.reduced_)
+        return num_ == r.num_ && den_ == r.den_;
+
+    return num_ * r.den_ == r.num_ * den_;
+}
+
+
+bool LongRational::operator!=(const LongRational & r) const
+{
+    return !(*this == r);
+}
+
+
+bool LongRational::operator>(const LongRational & r) const
+{
+    //Different signs, or a zero, settle it without multiplying.
+    if (sign() != r.sign() || num_ == 0 || r.num_ == 0)
+        return num_ > r.num_;
+
+    if (den_ == r.den_)
+        return num_ > r.num_;
+
+    //Both denominators are positive.
+    return num_ * r.den_ > r.num_ * den_;
+}
+
+
+bool LongRational::operator>=(const LongRational & r) const
+{
+    return !(*this < r);
+}
+
+
+bool LongRational::operator<(const LongRational & r) const
+{
+    return r > *this;
+}
+
+
+bool LongRational::operator<=(const LongRational & r) const
+{
+    return !(*this > r);
+}
+
+
+LongRational & LongRational::operator+=(const LongRational & r)
+{
+    return add(r, 1);
+}
+
+
+LongRational LongRational::operator+(const LongRational & r) const
+{
+    return LongRational(*this) += r;
+}
+
+
+LongRational & LongRational::operator-=(const LongRational & r)
+{
+    return add(r, -1);
+}
+
+
+LongRational LongRational::operator-(const LongRational & r) const
+{
+    return LongRational(*this) -= r;
+}
+
+
+LongRational LongRational::operator-() const
+{
+    LongRational ret(*this);
+    if (ret.num_ != 0)
+        ret.num_.sign() *= -1;
+
+    return ret;
+}
+
+
+LongRational & LongRational::operator*=(const LongRational & r)
+{
+    if (this == &r)
+        return *this *= LongRational(r);
+
+    //Knuth: with both in lowest terms, any common factor is
+    //between one's numerator and the other's denominator.
+    if (reduced_ && r.reduced_ &&
+        den_.limb_count() + r.den_.limb_count() > limit_)
+    {
+        LongInt g1 = gcd(num_, r.den_), g2 = gcd(den_, r.num_);
+        num_ = (num_ / g1) * (r.num_ / g2);
+        den_ = (den_ / g2) * (r.den_ / g1);
+        normalize();
+    }
+
+    else
+    {
+        num_ *= r.num_;
+        den_ *= r.den_;
+        reduced_ = (den_ == 1);
+        settle();
+    }
+
+    return *this;
+}
+
+
+LongRational LongRational::operator*(const LongRational & r) const
+{
+    return LongRational(*this) *= r;
+}
+
+
+LongRational & LongRational::operator/=(const LongRational & r)
+{
+    if (r.num_ == 0)
+        throw DivideByZeroError();
+
+    //Flipping a fraction keeps it in lowest terms.
+    LongRational flip;
+    flip.num_ = r.den_;
+    flip.den_ = r.num_;
+    if (flip.den_.sign() == -1)
+    {
+        flip.den_.sign() = 1;
+        flip.num_.sign() = -1;
+    }
+    flip.reduced_ = r.reduced_;
+
+    return *this *= flip;
+}
+
+
+LongRational LongRational::operator/(const LongRational & r) const
+{
+    return LongRational(*this) /= r;
+}
+
+
+LongInt LongRational::floor() const
+{
+    LongInt q, rem;
+    num_.divmod(den_, q, rem);
+
+    //Division rounds toward zero.
+    if (rem.sign() == -1 && rem != 0)
+        q -= 1;
+
+    return q;
+}
+
+
+std::string LongRational::to_string(const int base) const
+{
+    normalize();
+    if (den_ == 1)
+        return num_.to_string(base);
+
+    return num_.to_string(base) + "/" + den_.to_string(base);
+}
+
+
+LongRational & LongRational::add(const LongRational & r, const int r_sign)
+{
+    if (this == &r)
+        return add(LongRational(r), r_sign);
+
+    if (den_ == r.den_)
+    {
+        if (r_sign == 1)
+            num_ += r.num_;
+        else
+            num_ -= r.num_;
+        reduced_ = (den_ == 1);
+    }
+
+    //Henrici: with both in lowest terms and g = gcd(b, d),
+    //a/b + c/d = t / (b d / g) for t = a (d / g) + c (b / g), and
+    //only gcd(t, g) can still divide out.
+    else if (reduced_ && r.reduced_ &&
+             den_.limb_count() + r.den_.limb_count() > limit_)
+    {
+        LongInt g = gcd(den_, r.den_);
+        LongInt b = den_ / g, d = r.den_ / g;
+        LongInt t = num_ * d;
+        if (r_sign == 1)
+            t += r.num_ * b;
+        else
+            t -= r.num_ * b;
+
+        LongInt g2 = gcd(t, g);
+        num_ = t / g2;
+        den_ = b * (r.den_ / g2);
+        normalize();
+
+        return *this;
+    }
+
+    else
+    {
+        num_ *= r.den_;
+        if (r_sign == 1)
+            num_ += r.num_ * den_;
+        else
+            num_ -= r.num_ * den_;
+        den_ *= r.den_;
+        reduced_ = false;
+    }
+
+    settle();
+
+    return *this;
+}
+
+
+void LongRational::settle()
+{
+    if (num_ == 0)
+    {
+        den_ = 1;
+        reduced_ = true;
+    }
+
+    if (den_.limb_count() > limit_)
+        normalize();
+
+    return;
+}
+
+
+LongRational abs(const LongRational & r)
+{
+    return (r.sign() == -1 ? -r : r);
+}
+
+
+std::ostream & operator<<(std::ostream & out, const LongRational & r)
+{
+    return out << r.to_string();
+}
@@ -0,0 +1,103 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: LongRational.h
+
+/*
+  Exact fractions of LongInts.
+
+  Keeping a fraction in lowest terms after every operation costs a
+  GCD each time, which is usually more than the operation itself.
+  A LongRational instead lets its numerator and denominator grow
+  and only reduces them once the denominator passes a limit, or when
+  the numerator and denominator are asked for or printed. After
+  each reduction the limit becomes twice the reduced size, so a
+  value that really is that big isn't reduced again and again for
+  nothing.
+
+  Operations also use shortcuts where they are cheaper:
+      - equal denominators are added without cross multiplying
+      - comparisons cross multiply instead of reducing
+      - once a result would be reduced anyway and both operands
+        are in lowest terms, + and * take the GCDs of the smaller
+        pieces first (Henrici's and Knuth's methods), so the result
+        comes out in lowest terms without a GCD of the full size.
+
+  The denominator is always positive. Dividing by zero, including a
+  zero denominator, throws DivideByZeroError.
+*/
+
+#ifndef LONG_RATIONAL_H
+#define LONG_RATIONAL_H
+
+#include "LongInt.h"
+
+class LongRational
+{
+public:
+    //Denominator length, in limbs, under which a fraction is left
+    //unreduced.
+    static constexpr int REDUCE_LIMBS = 8;
+
+    LongRational();
+    LongRational(const int);
+    LongRational(const LongInt&);
+    LongRational(const LongInt&, const LongInt&);
+    //"n" or "n/d".
+    LongRational(const char[]);
+
+    //In lowest terms.
+    const LongInt & numerator() const;
+    const LongInt & denominator() const;
+
+    //1 == positive or zero, -1 == negative, same as LongInt.
+    inline
+    int sign() const { return num_.sign(); }
+
+    //Put the fraction in lowest terms now.
+    void normalize() const;
+    inline
+    bool is_normalized() const { return reduced_; }
+
+    bool operator==(const LongRational&) const;
+    bool operator!=(const LongRational&) const;
+    bool operator> (const LongRational&) const;
+    bool operator>=(const LongRational&) const;
+    bool operator< (const LongRational&) const;
+    bool operator<=(const LongRational&) const;
+
+    LongRational & operator+=(const LongRational&);
+    LongRational   operator+(const LongRational&) const;
+    LongRational & operator-=(const LongRational&);
+    LongRational   operator-(const LongRational&) const;
+    LongRational   operator-() const;
+    LongRational & operator*=(const LongRational&);
+    LongRational   operator*(const LongRational&) const;
+    LongRational & operator/=(const LongRational&);
+    LongRational   operator/(const LongRational&) const;
+
+    //Rounded toward negative infinity.
+    LongInt floor() const;
+
+    //"n/d" in lowest terms, or just "n" for a whole number.
+    std::string to_string(const int base = 10) const;
+
+private:
+    //Reducing changes how the value is written, not the value, so
+    //it can happen through const methods.
+    mutable LongInt num_;
+    mutable LongInt den_;
+    mutable bool reduced_;
+    mutable int limit_;
+
+    //*this += r_sign * r.
+    LongRational & add(const LongRational&, const int);
+
+    //Reduce if the denominator has passed the limit.
+    void settle();
+};
+
+LongRational abs(const LongRational&);
+
+std::ostream & operator<<(std::ostream&, const LongRational&);
+
+#endif
@@ -0,0 +1,251 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: ModContext.cpp
+
+#include "ModContext.h"
+#include "LongIntStats.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    int bit_length(const LimbArr & x)
+    {
+        if (x.empty())
+            return 0;
+
+        int bits = (x.size() - 1) * LIMB_BITS;
+        for (limb_t top = x.back(); top != 0; top >>= 1)
+            bits++;
+
+        return bits;
+    }
+
+    inline
+    int get_bit(const LimbArr & x, const int i)
+    {
+        return (x[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1;
+    }
+
+    //Window width for an exponent of the given length, trading
+    //the 2^(k-1) table entries against one multiply per k bits.
+    int window_bits(const int bits)
+    {
+        if (bits <= 8)
+            return 1;
+        if (bits <= 24)
+            return 2;
+        if (bits <= 80)
+            return 3;
+        if (bits <= 240)
+            return 4;
+        if (bits <= 672)
+            return 5;
+        if (bits <= 1792)
+            return 6;
+
+        return 7;
+    }
+}
+
+
+ModContext::ModContext(const LongInt & m) :
+    m_(m.abs()),
+    n_(m.limb_count()),
+    mont_(false),
+    inv_(0)
+{
+    if (n_ == 0)
+        throw DivideByZeroError();
+
+    const limb_t * md = m_.limbs();
+    mont_ = (md[0] & 1) && n_ < limb_thresholds.redc;
+
+    if (mont_)
+    {
+        //R^2 mod m from dividing 2^(64n) by m.
+        inv_ = limbs_mont_inv(md[0]);
+
+        LimbArr num(2 * n_ + 1), q(n_ + 2);
+        num[2 * n_] = 1;
+        r2_.resize(n_);
+        limbs_divrem(q.data(), r2_.data(), num.data(), num.size(), md, n_);
+    }
+
+    else
+    {
+        mu_.resize(n_ + 2);
+        limbs_barrett_inv(mu_.data(), md, n_);
+    }
+
+    return;
+}
+
+
+LongInt ModContext::reduce(const LongInt & x) const
+{
+    LongInt ret = x % m_;
+    if (ret.sign() == -1)
+        ret += m_;
+
+    return ret;
+}
+
+
+LongInt ModContext::mul(const LongInt & a, const LongInt & b) const
+{
+    stats_op(STAT_MULMOD, n_);
+    LimbArr x = reduce_n(a), y = reduce_n(b);
+    LimbVector t(scratch_size());
+
+    mul_n(x.data(), x.data(), y.data(), t.data());
+
+    //x is now a * b / R, one more product with R^2 takes the
+    //R back out.
+    if (mont_)
+        mul_n(x.data(), x.data(), r2_.data(), t.data());
+
+    return to_longint(x.data());
+}
+
+
+LongInt ModContext::pow(const LongInt & base, const LongInt & exp) const
+{
+    //base^-e = (1 / base)^e.
+    if (exp.sign() == -1)
+        return pow(modinv(base, m_), -LongInt(exp));
+    stats_op(STAT_POWMOD, n_);
+
+    const int bits = bit_length(exp.x_);
+    if (bits == 0)
+        return reduce(1);
+
+    const int n = n_;
+    LimbVector t(scratch_size());
+
+    //Odd powers base^1, base^3, ..., base^(2^k - 1), in
+    //Montgomery form if that is in use.
+    const int k = window_bits(bits);
+    std::vector<LimbArr> table(1 << (k - 1));
+    table[0] = reduce_n(base);
+    if (mont_)
+        mul_n(table[0].data(), table[0].data(), r2_.data(), t.data());
+
+    if (k > 1)
+    {
+        LimbArr sq(n);
+        mul_n(sq.data(), table[0].data(), table[0].data(), t.data());
+        for (int i = 1; i < static_cast<int>(table.size()); i++)
+        {
+            table[i].resize(n);
+            mul_n(table[i].data(), table[i - 1].data(), sq.data(),
+                  t.data());
+        }
+    }
+
+    //Left to right. Zero bits are single squarings; otherwise
+    //take the longest window of at most k bits that ends in a
+    //one, square once per bit and multiply by its table entry.
+    LimbArr acc;
+    bool started = false;
+    for (int i = bits - 1; i >= 0; )
+    {
+        if (get_bit(exp.x_, i) == 0)
+        {
+            mul_n(acc.data(), acc.data(), acc.data(), t.data());
+            i--;
+            continue;
+        }
+
+        int j = std::max(i - k + 1, 0);
+        while (get_bit(exp.x_, j) == 0)
+            j++;
+
+        int w = 0;
+        for (int b = i; b >= j; b--)
+            w = (w << 1) | get_bit(exp.x_, b);
+
+        if (!started)
+        {
+            acc = table[w >> 1];
+            started = true;
+        }
+        else
+        {
+            for (int b = i; b >= j; b--)
+                mul_n(acc.data(), acc.data(), acc.data(), t.data());
+            mul_n(acc.data(), acc.data(), table[w >> 1].data(), t.data());
+        }
+
+        i = j - 1;
+    }
+
+    //Out of Montgomery form: multiply by 1.
+    if (mont_)
+    {
+        LimbArr one(n);
+        one[0] = 1;
+        mul_n(acc.data(), acc.data(), one.data(), t.data());
+    }
+
+    return to_longint(acc.data());
+}
+
+
+void ModContext::mul_n(limb_t * r, const limb_t * a, const limb_t * b,
+                       limb_t * t) const
+{
+    const int n = n_;
+    limbs_mul(t, a, n, b, n);
+
+    if (mont_)
+    {
+        StatTimer timer(TIER_MOD_MONTGOMERY);
+        limbs_redc(r, t, m_.limbs(), n, inv_);
+    }
+    else
+    {
+        StatTimer timer(TIER_MOD_BARRETT);
+        limbs_barrett_reduce(r, t, m_.limbs(), n, mu_.data(), t + 2 * n);
+    }
+
+    return;
+}
+
+
+int ModContext::scratch_size() const
+{
+    return 2 * n_ + (mont_ ? 0 : limbs_barrett_scratch(n_));
+}
+
+
+LimbArr ModContext::reduce_n(const LongInt & x) const
+{
+    LongInt r = reduce(x);
+    LimbArr ret(r.x_);
+    ret.resize(n_);
+
+    return ret;
+}
+
+
+LongInt ModContext::to_longint(const limb_t * x) const
+{
+    LongInt ret;
+    ret.x_.assign(x, x + n_);
+    ret.trim();
+
+    return ret;
+}
+
+
+/////////////////
+///NON-MEMBERS///
+/////////////////
+
+
+LongInt powmod(const LongInt & base, const LongInt & exp, const LongInt & m)
+{
+    return ModContext(m).pow(base, exp);
+}
@@ -0,0 +1,79 @@
+//Name: Grant Clark
+//Date: November ??, 2021
+//File: ModContext.h
+
+/*
+  Arithmetic modulo a fixed LongInt. Building a ModContext does the
+  per modulus work once (Montgomery constants for an odd modulus,
+  the Barrett reciprocal otherwise), so keep one around when doing
+  many operations with the same modulus:
+
+      ModContext ctx(m);
+      for (...)
+          s = ctx.pow(s, e);
+
+  Results are always in [0, |m|), whatever the signs of the inputs.
+  A ModContext is not changed by using it, so one can be shared
+  between threads.
+*/
+
+#ifndef MOD_CONTEXT_H
+#define MOD_CONTEXT_H
+
+#include "LongInt.h"
+
+class ModContext
+{
+public:
+    //The modulus' sign is ignored. Throws DivideByZeroError for
+    //zero.
+    explicit ModContext(const LongInt&);
+
+    //|m|.
+    inline
+    const LongInt & modulus() const { return m_; }
+
+    //True if Montgomery reduction is used, false for Barrett.
+    inline
+    bool montgomery() const { return mont_; }
+
+    //x mod |m|.
+    LongInt reduce(const LongInt&) const;
+
+    //a * b mod |m|.
+    LongInt mul(const LongInt&, const LongInt&) const;
+
+    //base^exp mod |m| by sliding window exponentiation. A
+    //negative exp raises the inverse of base, and throws
+    //NotInvertibleError if base has none.
+    LongInt pow(const LongInt&, const LongInt&) const;
+
+private:
+    LongInt m_;
+    int n_;
+    bool mont_;
+
+    //Montgomery: -1 / m mod 2^32 and R^2 mod m, R = 2^(32n).
+    limb_t inv_;
+    LimbArr r2_;
+
+    //Barrett: 2^(64n) / m.
+    LimbArr mu_;
+
+    //r = a * b reduced, for n limb a and b less than m. t holds
+    //scratch_size() limbs. r may be a or b.
+    void mul_n(limb_t *, const limb_t *, const limb_t *, limb_t *) const;
+    int scratch_size() const;
+
+    //x mod m as n limbs.
+    LimbArr reduce_n(const LongInt&) const;
+
+    //n limbs back to a LongInt.
+    LongInt to_longint(const limb_t *) const;
+};
+
+//base^exp mod |m|. Builds a ModContext, so use one directly when
+//the modulus is reused.
+LongInt powmod(const LongInt&, const LongInt&, const LongInt&);
+
+#endif